@@ -0,0 +1,316 @@
+/*
+ *  BART: Bayesian Additive Regression Trees
+ *  Copyright (C) 2017 Robert McCulloch and Rodney Sparapani
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-2
+ */
+
+// MCMC throughput benchmark built against the header-only library
+// in ../include, e.g., "make bench.out" then
+// ./bench.out n=10000 p=10 ntree=200 type=wbart sparse=1 nd=1000 burn=100
+// type is wbart, pbart, lbart or pgbart; sparse is 1 (off), 2 (DART),
+// 3 (logit-normal) or 4 (logit-normal LASSO) as in cgbart; pchange and
+// pswap are the probabilities of the change and swap moves
+// ESS/sec is of sigma for wbart, else of the mean of f over x, by the
+// initial positive sequence estimator of Geyer (1992); then gbart() is
+// run with the same settings and a sink that keeps no draws to count its
+// heap allocations after burn-in: other than the two nodes of each
+// accepted birth, only the exhausted-variable lists of new nodes, or of
+// the nodes at burn-in, should remain and the run fails (exit 1) if
+// there are more
+
+#include <BART3.h>
+#include <BART3/PolyaGamma.h>
+#include <sys/resource.h>
+#include <cstring>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock bclock;
+
+//every heap allocation of the program is counted
+static size_t nalloc=0;
+void* operator new(size_t sz)
+{
+  ++nalloc;
+  if(void *ptr=malloc(sz ? sz : 1)) return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept {free(ptr);}
+void operator delete(void *ptr, size_t) noexcept {free(ptr);}
+
+double seconds(bclock::time_point a, bclock::time_point b)
+{
+  return std::chrono::duration<double>(b-a).count();
+}
+
+//effective sample size: autocovariances are summed in pairs while positive
+double ess(std::vector<double>& s)
+{
+  size_t N=s.size();
+  double mu=0., g0, tau=-1.;
+  for(size_t i=0; i<N; ++i) mu+=s[i];
+  mu/=N;
+  auto acov=[&s, N, mu](size_t k) {
+    double g=0.;
+    for(size_t i=0; i+k<N; ++i) g+=(s[i]-mu)*(s[i+k]-mu);
+    return g/N;
+  };
+  g0=acov(0);
+  if(g0<=0.) return N;
+  for(size_t k=0; k+1<N; k+=2) {
+    double G=acov(k)+acov(k+1);
+    if(G<=0.) break;
+    tau+=2.*G/g0;
+  }
+  return N/std::max(tau, 1.);
+}
+
+//keeps none of the draws of gbart() but the heap allocations, births and
+//tree sizes from the first kept draw, i.e., after burn-in
+class allocsink: public gbartsink
+{
+ public:
+  allocsink():alloc0(0),allocs(0),birth0(0),births(0),size0(0) {}
+  virtual void trees(size_t d, heterbart& bm) {
+    if(d==0) {
+      for(size_t j=0; j<m; j++) size0+=bm.gettree(j).treesize();
+      birth0=bm.getci().bacc;
+      alloc0=nalloc;
+    }
+    allocs=nalloc-alloc0;
+    births=bm.getci().bacc-birth0;
+  }
+  size_t alloc0, allocs, birth0, births, size0;
+};
+
+//Friedman (1991): f(x)=10sin(pi x1 x2)+20(x3-.5)^2+10x4+5x5
+double friedman(double *x)
+{
+  return 10.*sin(PI*x[0]*x[1])+20.*pow(x[2]-0.5, 2.)+10.*x[3]+5.*x[4];
+}
+
+int main(int argc, char** argv) {
+  size_t n=10000, p=10, m=200, nd=1000, burn=100, sparse=1;
+  double pchange=0., pswap=0.;
+  unsigned int seed=99;
+  std::string type="wbart";
+
+  for(int i=1; i<argc; ++i) {
+    char *val=strchr(argv[i], '=');
+    if(!val) {
+      cout << "arguments are name=value, see the top of bench.cpp\n";
+      return 1;
+    }
+    *val++='\0';
+    if(!strcmp(argv[i], "n")) n=atol(val);
+    else if(!strcmp(argv[i], "p")) p=atol(val);
+    else if(!strcmp(argv[i], "ntree")) m=atol(val);
+    else if(!strcmp(argv[i], "nd")) nd=atol(val);
+    else if(!strcmp(argv[i], "burn")) burn=atol(val);
+    else if(!strcmp(argv[i], "sparse")) sparse=atol(val);
+    else if(!strcmp(argv[i], "seed")) seed=atol(val);
+    else if(!strcmp(argv[i], "pchange")) pchange=atof(val);
+    else if(!strcmp(argv[i], "pswap")) pswap=atof(val);
+    else if(!strcmp(argv[i], "type")) type=val;
+    else {
+      cout << "unknown argument: " << argv[i] << '\n';
+      return 1;
+    }
+  }
+
+  int itype = type=="wbart" ? 1 : type=="pbart" ? 2 :
+    type=="lbart" ? 3 : type=="pgbart" ? 4 : 0;
+  if(itype==0 || p<5 || sparse<1 || sparse>4 || pchange<0. || pswap<0. ||
+     pchange+pswap>=1.) {
+    cout << "type must be wbart, pbart, lbart or pgbart, p>=5, 1<=sparse<=4"
+	 << " and pchange+pswap<1\n";
+    return 1;
+  }
+
+  //--------------------------------------------------
+  //data: x is pxn (rows contiguous), binary y from the centered f
+  arn gen(seed, 2*seed);
+  std::vector<double> x(n*p), y(n), z(n), w(n), sign(n), lam(n), lmean(n);
+  double ymu=0., ysd=0.;
+  for(size_t i=0; i<n; ++i) {
+    for(size_t j=0; j<p; ++j) x[i*p+j]=gen.uniform();
+    double f=friedman(&x[i*p]);
+    if(itype==1) y[i]=f+gen.normal();
+    else y[i]=(f-14.4)/5.+gen.normal()>0. ? 1. : 0.;
+    ymu+=y[i];
+  }
+  ymu/=n;
+  for(size_t i=0; i<n; ++i) ysd+=pow(y[i]-ymu, 2.);
+  ysd=sqrt(ysd/(n-1.));
+
+  //--------------------------------------------------
+  //priors as in gbart
+  double k=2., nu=3., sigma=ysd, Offset, tau, lambda;
+  lambda = pow(ysd, 2.)*::qchisq(0.1, nu, 1, 0)/nu;
+  if(itype==1) {
+    Offset=ymu;
+    tau=(*std::max_element(y.begin(), y.end())-
+	 *std::min_element(y.begin(), y.end()))/(2.*k*sqrt(m));
+  }
+  else {
+    Offset = itype==2 ? ::qnorm(ymu, 0., 1., 1, 0) : log(ymu/(1.-ymu));
+    tau = (itype==2 ? 3. : 6.)/(k*sqrt(m));
+  }
+  for(size_t i=0; i<n; ++i) {
+    w[i]=1.;
+    if(itype==1) z[i]=y[i]-Offset;
+    else {
+      sign[i] = y[i]==0. ? -1. : 1.;
+      z[i]=sign[i];
+      lam[i]=1.;
+      if(itype==4) {
+	w[i]=0.25;
+	z[i]=2.*sign[i]-Offset;
+      }
+    }
+  }
+
+  std::vector<int> numcut(p, 100);
+  heterbart bm(m);
+  bm.setprior(0.95, 2., tau);
+  bm.setmoves(1.-pchange-pswap, pchange);
+  bm.setdata(p, n, &x[0], &z[0], &numcut[0]);
+  bm.setw(&w[0], itype<=2); //w is all ones for wbart and pbart
+  if(itype==1) bm.setwscale(1./(sigma*sigma));
+  std::vector<double> varprob(p, 1./p), lpv(p);
+  vs varsel(sparse, p);
+  Eigen::MatrixXd an=Eigen::MatrixXd::Zero(1, 1);
+  if(sparse==2) varsel.setvs_dart(0.5, 1., false, p, 0., 0.);
+  else if(sparse>2) varsel.setvs_ln(100., 0.01, an, 0, sparse==4, gen);
+  bm.setpv(&varprob[0]);
+  lambdaprior lprior(1000);
+  PolyaGamma pgdraw(1);
+
+  //--------------------------------------------------
+  //mcmc: the tree updates are timed separately from the rest
+  size_t total=nd+burn;
+  double ttree=0., checksum=0., fbar;
+  std::vector<double> trace;
+  trace.reserve(nd);
+  bclock::time_point start=bclock::now(), tick;
+  for(size_t i=0; i<total; i++) {
+    if(i==(burn/2)) varsel.turn_on();
+    tick=bclock::now();
+    bm.draw(gen);
+    ttree+=seconds(tick, bclock::now());
+    if(sparse>1 && varsel.is_on()) {
+      std::vector<size_t>& nv=bm.getnv();
+      size_t R=0;
+      for(size_t j=0; j<p; j++) R+=nv[j];
+      varsel.set_R(R);
+      if(sparse==2) {
+	varsel.draw_s_dart(lpv, nv, gen);
+	varsel.draw_theta0_dart(lpv, gen);
+      }
+      else {
+	varsel.draw_s_ln(nv, lpv, gen);
+	varsel.draw_tau2_ln(gen);
+	if(sparse==4) varsel.draw_lambda_lnLASSO(gen);
+      }
+      for(size_t j=0; j<p; j++) varprob[j]=::exp(lpv[j]);
+      bm.setpv(&varprob[0]);
+    }
+    if(itype==1) {
+      sigma = sqrt((nu*lambda + bm.getrss())/gen.chi_square(n+nu));
+      bm.setwscale(1./(sigma*sigma));
+      if(i>=burn) {
+	checksum+=sigma;
+	trace.push_back(sigma);
+      }
+    }
+    else for(size_t h=0; h<n; h++) {
+      if(itype==4) {
+	w[h]=pgdraw.draw(1, Offset+bm.f(h), gen);
+	z[h]=0.5*sign[h]/w[h]-Offset;
+      }
+      else {
+	z[h]=sign[h]*rtnorm(sign[h]*bm.f(h), -sign[h]*Offset, sqrt(lam[h]), gen);
+	lmean[h]=sign[h]*bm.f(h);
+      }
+    }
+    if(itype==3) {
+      draw_lambda(n, &lam[0], &lmean[0], lprior, 1, gen);
+      for(size_t h=0; h<n; h++) w[h]=1./lam[h];
+    }
+    if(i>=burn) {
+      fbar=0.;
+      for(size_t h=0; h<n; h++) fbar+=bm.f(h);
+      checksum+=fbar;
+      if(itype!=1) trace.push_back(fbar/n);
+    }
+  }
+  double telapsed=seconds(start, bclock::now());
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  //--------------------------------------------------
+  //the allocations of gbart() with the settings above
+  gbartcfg cfg;
+  cfg.type=itype;
+  cfg.n=n; cfg.p=p; cfg.m=m;
+  cfg.nd=nd; cfg.burn=burn; cfg.thin=1;
+  cfg.Offset=Offset; cfg.tau=tau;
+  cfg.nu=nu; cfg.lambda = itype==1 ? lambda : 1.;
+  cfg.sigma = itype==1 ? ysd : 1.;
+  cfg.sparse=sparse; cfg.rho=p;
+  cfg.bprvar=100.; cfg.tprprm=0.01;
+  cfg.numcut=numcut;
+  cfg.pbd=1.-pchange-pswap; cfg.pchange=pchange;
+  cfg.printevery=total;
+  std::vector<double> gy(n), gw(n, 1.), gvarprob(p, 1./p);
+  for(size_t i=0; i<n; i++) gy[i] = itype==1 ? y[i]-Offset : y[i];
+  arn ggen(seed, 2*seed);
+  allocsink out;
+  gbart(cfg, &x[0], &gy[0], 0, &gw[0], &gvarprob[0], ggen, out);
+
+#ifdef RNG_random
+  cout << "rng: RNG_random\n";
+#elif defined (RNG_Rmath)
+  cout << "rng: RNG_Rmath\n";
+#endif
+  printf("type: %s, sparse: %zu, n: %zu, p: %zu, ntree: %zu, iterations: %zu\n",
+	 type.c_str(), sparse, n, p, m, total);
+  printf("moves: birth/death %g, change %g, swap %g\n", 1.-pchange-pswap,
+	 pchange, pswap);
+  printf("iterations/sec: %.3f\n", total/telapsed);
+  printf("ns/tree update: %.1f\n", 1e9*ttree/(total*m));
+  printf("tree update share: %.3f\n", ttree/telapsed);
+  if(nd>1) {
+    double e=ess(trace);
+    printf("ESS: %.1f\n", e);
+    printf("ESS/sec: %.3f\n", e/telapsed);
+  }
+  printf("peak RSS (KB): %ld\n", usage.ru_maxrss);
+  printf("checksum: %.17g\n", checksum);
+  printf("gbart() heap allocations after burn-in: %zu (births: %zu)\n",
+	 out.allocs, out.births);
+
+  //the steady state: two nodes for each birth and at most one
+  //exhausted-variable list for each of them or of the nodes at burn-in
+  size_t bound=4*out.births+out.size0;
+  if(out.allocs>bound) {
+    printf("FAILED: gbart() heap allocations after burn-in %zu > %zu\n",
+	   out.allocs, bound);
+    return 1;
+  }
+
+  return 0;
+}
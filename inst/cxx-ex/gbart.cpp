@@ -0,0 +1,316 @@
+/*
+ *  BART: Bayesian Additive Regression Trees
+ *  Copyright (C) 2017 Robert McCulloch and Rodney Sparapani
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-2
+ */
+
+// gbart without R: the engine in ../include/BART3/gbart.h, e.g.,
+// "make gbart.out" then
+// ./gbart.out x=x.csv y=y.csv xtest=xp.csv type=wbart out=fit
+// x, y and xtest are CSV (.csv, an optional header is skipped) or
+// binary doubles, row-major with p= columns for x and xtest
+// the priors are set as in gbart: see the table of arguments below
+// writes out.trees and out.cutpoints.csv (the treedraws for read.trees),
+// out.train.csv and out.test.csv (posterior mean and sd of f(x)),
+// out.varcount.csv, out.sigma.csv (wbart) and out.diagnostics.csv
+// (diagevery>0); draws=1 also writes the draws of f(x) to out.train.bin
+// and out.test.bin as row-major doubles with a row per kept draw
+// checkpoint=file checkevery=N writes the state of the MCMC every N
+// iterations and resume=file continues from it: the outputs then only
+// have the draws after the checkpoint; pchange= and pswap= are the
+// probabilities of the change and swap tree moves, adapt=1 adapts them
+// during burn-in
+
+#include <BART3.h>
+#include <map>
+#include <cstring>
+#include <cstdlib>
+
+//reads a row-major matrix: a CSV file or binary doubles with cols columns
+bool readmat(std::string file, size_t cols, std::vector<double>& x,
+	     size_t& rows)
+{
+  x.clear();
+  if(file.size()>4 && file.substr(file.size()-4)==".csv") {
+    std::ifstream in(file.c_str());
+    if(!in) return false;
+    std::string line;
+    size_t cnt=0;
+    rows=0;
+    while(std::getline(in, line)) {
+      if(line.find_first_not_of(" \t\r")==std::string::npos) continue;
+      std::stringstream ss(line);
+      std::string field;
+      std::vector<double> row;
+      bool numeric=true;
+      while(std::getline(ss, field, ',')) {
+	char *end;
+	double v=strtod(field.c_str(), &end);
+	if(end==field.c_str()) numeric=false;
+	row.push_back(v);
+      }
+      if(!numeric) {
+	if(rows==0 && x.size()==0) continue; //header
+	return false;
+      }
+      if(cnt==0) cnt=row.size();
+      if(row.size()!=cnt || (cols && cnt!=cols)) return false;
+      x.insert(x.end(), row.begin(), row.end());
+      ++rows;
+    }
+    return rows>0;
+  }
+  else {
+    std::ifstream in(file.c_str(), std::ios::binary|std::ios::ate);
+    if(!in || cols==0) return false;
+    size_t bytes=in.tellg();
+    if(bytes%(cols*sizeof(double))) return false;
+    rows=bytes/(cols*sizeof(double));
+    x.resize(rows*cols);
+    in.seekg(0);
+    in.read((char*)&x[0], bytes);
+    return rows>0;
+  }
+}
+
+//streams the tree draws to a file and keeps the posterior mean and
+//sd of f(x) rather than the draws
+class clisink: public gbartsink
+{
+ public:
+  clisink(std::string _out, bool _draws):out(_out),draws(_draws) {}
+  virtual void init(const gbartcfg& cfg, size_t start) {
+    gbartsink::init(cfg, start);
+    treefile.open((out+".trees").c_str());
+    treefile.precision(10);
+    treefile << nkeep << " " << m << " " << p << endl;
+    trsum.assign(2*n, 0.);
+    tesum.assign(2*np, 0.);
+    if(draws) {
+      trbin.open((out+".train.bin").c_str(), std::ios::binary);
+      if(np) tebin.open((out+".test.bin").c_str(), std::ios::binary);
+    }
+    if(cfg.type==1 && cfg.lambda!=0.) sig.open((out+".sigma.csv").c_str());
+    varcnt.open((out+".varcount.csv").c_str());
+    if(cfg.ndiag()) {
+      diagnostics.open((out+".diagnostics.csv").c_str());
+      diagnostics << "tree,latent,varsel,sigma,impute,test,treedraws,"
+		  << "birth.proposed,birth.accepted,death.proposed,death.accepted\n";
+    }
+  }
+  virtual void cutpoints(xinfo& xi) {
+    std::ofstream cut((out+".cutpoints.csv").c_str());
+    cut.precision(17);
+    for(size_t j=0; j<xi.size(); j++) {
+      for(size_t k=0; k<xi[j].size(); k++) cut << (k ? "," : "") << xi[j][k];
+      cut << '\n';
+    }
+  }
+  virtual void sigma(size_t i, double s) {sig << s << '\n';}
+  virtual void train(size_t d, const double* f) {
+    for(size_t k=0; k<n; k++) {
+      trsum[2*k]+=f[k];
+      trsum[2*k+1]+=f[k]*f[k];
+    }
+    if(draws) trbin.write((const char*)f, n*sizeof(double));
+  }
+  virtual void test(size_t d, const double* f) {
+    for(size_t k=0; k<np; k++) {
+      tesum[2*k]+=f[k];
+      tesum[2*k+1]+=f[k]*f[k];
+    }
+    if(draws) tebin.write((const char*)f, np*sizeof(double));
+  }
+  virtual void trees(size_t d, heterbart& bm) {
+    for(size_t j=0; j<m; j++) treefile << bm.gettree(j);
+    std::vector<size_t>& nv=bm.getnv();
+    for(size_t j=0; j<p; j++) varcnt << (j ? "," : "") << nv[j];
+    varcnt << '\n';
+  }
+  virtual void diag(size_t g, const double* dg, heterbart& bm) {
+    for(size_t j=0; j<11; j++) diagnostics << (j ? "," : "") << dg[j];
+    diagnostics << '\n';
+  }
+  //posterior mean and sd of f(x) from the sums
+  void summary(std::string file, std::vector<double>& s, size_t rows) {
+    if(rows==0) return;
+    std::ofstream sum(file.c_str());
+    sum.precision(10);
+    sum << "mean,sd\n";
+    for(size_t k=0; k<rows; k++) {
+      double mean=s[2*k]/nkeep, var=s[2*k+1]/nkeep-mean*mean;
+      sum << mean << ',' << sqrt(var>0. ? var : 0.) << '\n';
+    }
+  }
+  void finish() {
+    summary(out+".train.csv", trsum, n);
+    summary(out+".test.csv", tesum, np);
+  }
+ private:
+  std::string out;
+  bool draws;
+  std::vector<double> trsum, tesum;
+  std::ofstream treefile, trbin, tebin, sig, varcnt, diagnostics;
+};
+
+int main(int argc, char** argv) {
+  //arguments with their defaults: NA is set from the data as in gbart
+  std::map<std::string, std::string> arg;
+  const char* defaults[][2]={
+    {"x", ""}, {"y", ""}, {"xtest", ""}, {"p", "0"}, {"type", "wbart"},
+    {"ntree", "NA"}, {"numcut", "100"}, {"ndpost", "1000"},
+    {"nskip", "100"}, {"keepevery", "NA"}, {"k", "2"}, {"power", "2"},
+    {"base", "0.95"}, {"sigdf", "3"}, {"sigquant", "0.9"}, {"sigest", "NA"},
+    {"lambda", "NA"}, {"tau.num", "NA"}, {"offset", "NA"}, {"sparse", "1"},
+    {"a", "0.5"}, {"b", "1"}, {"rho", "0"}, {"theta", "0"},
+    {"bprvar", "100"}, {"t2prprm", "0.01"},
+    {"printevery", "100"}, {"diagevery", "0"},
+    {"checkpoint", ""}, {"checkevery", "0"}, {"resume", ""},
+    {"pchange", "0"}, {"pswap", "0"}, {"adapt", "0"},
+    {"seed", "99"}, {"draws", "0"}, {"out", "gbart"}};
+  for(size_t i=0; i<sizeof(defaults)/sizeof(defaults[0]); ++i)
+    arg[defaults[i][0]]=defaults[i][1];
+  for(int i=1; i<argc; ++i) {
+    char *val=strchr(argv[i], '=');
+    if(!val) {
+      cout << "arguments are name=value, see the top of gbart.cpp\n";
+      return 1;
+    }
+    *val++='\0';
+    if(arg.find(argv[i])==arg.end()) {
+      cout << "unknown argument: " << argv[i] << '\n';
+      return 1;
+    }
+    arg[argv[i]]=val;
+  }
+#define NUM(a) atof(arg[a].c_str())
+#define NA(a) (arg[a]=="NA")
+
+  //--------------------------------------------------
+  //data: x is read row-major which is pxn column-major
+  gbartcfg cfg;
+  std::vector<double> x, y, xp;
+  size_t n, ny, np=0, p=NUM("p");
+  if(!readmat(arg["x"], p, x, n)) {
+    cout << "x= must be a CSV file or binary doubles with p= columns\n";
+    return 1;
+  }
+  if(p==0) p=x.size()/n;
+  if(!readmat(arg["y"], 1, y, ny) || ny!=n) {
+    cout << "y= must have one column and the rows of x\n";
+    return 1;
+  }
+  if(arg["xtest"]!="" && !readmat(arg["xtest"], p, xp, np)) {
+    cout << "xtest= must have the columns of x\n";
+    return 1;
+  }
+  cfg.type = arg["type"]=="wbart" ? 1 : arg["type"]=="pbart" ? 2 :
+    arg["type"]=="lbart" ? 3 : arg["type"]=="pgbart" ? 4 : 0;
+  if(cfg.type==0) {
+    cout << "type must be wbart, pbart, lbart or pgbart\n";
+    return 1;
+  }
+  cfg.n=n; cfg.p=p; cfg.np=np;
+  cfg.m = NA("ntree") ? (cfg.type==1 ? 200 : 50) : NUM("ntree");
+  cfg.nd=NUM("ndpost");
+  cfg.burn=NUM("nskip");
+  cfg.thin = NA("keepevery") ? (cfg.type==1 ? 1 : 10) : NUM("keepevery");
+  cfg.power=NUM("power");
+  cfg.base=NUM("base");
+  cfg.numcut.assign(p, (int)NUM("numcut"));
+  cfg.sparse=NUM("sparse");
+  cfg.a=NUM("a");
+  cfg.b=NUM("b");
+  cfg.rho=NUM("rho");
+  cfg.theta=NUM("theta");
+  cfg.bprvar=NUM("bprvar");
+  cfg.tprprm=NUM("t2prprm");
+  cfg.printevery=NUM("printevery");
+  cfg.diagevery=NUM("diagevery");
+  cfg.checkpoint=arg["checkpoint"];
+  cfg.checkevery=NUM("checkevery");
+  cfg.resume=arg["resume"];
+  cfg.pchange=NUM("pchange");
+  cfg.pbd=1.-cfg.pchange-NUM("pswap");
+  cfg.adapt=NUM("adapt")==1.;
+  if(cfg.sparse<1 || cfg.sparse>4 || cfg.thin==0 || cfg.nd<cfg.thin ||
+     cfg.pchange<0. || cfg.pbd<=0. || cfg.pbd+cfg.pchange>1.) {
+    cout << "sparse must be 1 (off), 2 (DART), 3 (logit-normal) or 4 "
+	 << "(logit-normal LASSO), keepevery<=ndpost and pchange+pswap<1\n";
+    return 1;
+  }
+
+  //--------------------------------------------------
+  //priors as in gbart
+  double k=NUM("k"), ymu=0., ysd=0., ymin=y[0], ymax=y[0];
+  for(size_t i=0; i<n; i++) {
+    ymu+=y[i];
+    ymin=std::min(ymin, y[i]);
+    ymax=std::max(ymax, y[i]);
+  }
+  ymu/=n;
+  for(size_t i=0; i<n; i++) ysd+=pow(y[i]-ymu, 2.);
+  ysd=sqrt(ysd/(n-1.));
+  if(!NA("offset")) cfg.Offset=NUM("offset");
+  else if(cfg.type==1) cfg.Offset=ymu;
+  else if(cfg.type==2) cfg.Offset=::qnorm(ymu, 0., 1., 1, 0);
+  else cfg.Offset=log(ymu/(1.-ymu));
+  double taunum = !NA("tau.num") ? NUM("tau.num") : cfg.type==2 ? 3. : 6.;
+  if(cfg.type==1) {
+    for(size_t i=0; i<n; i++) y[i]-=cfg.Offset;
+    double nu=NUM("sigdf"), sigest;
+    if(!NA("lambda")) {
+      cfg.lambda=NUM("lambda");
+      sigest = NA("sigest") ? sqrt(cfg.lambda) : NUM("sigest");
+    }
+    else {
+      if(!NA("sigest")) sigest=NUM("sigest");
+      else if(p<n) { //residual sd of the linear regression
+	Eigen::MatrixXd X(n, p+1);
+	Eigen::VectorXd Y(n);
+	for(size_t i=0; i<n; i++) {
+	  X(i, 0)=1.;
+	  for(size_t j=0; j<p; j++) X(i, j+1)=x[i*p+j];
+	  Y(i)=y[i];
+	}
+	Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(X);
+	double rss=(Y-X*qr.solve(Y)).squaredNorm();
+	sigest=sqrt(rss/(n-qr.rank()));
+      }
+      else sigest=ysd;
+      cfg.lambda=sigest*sigest*::qchisq(1.-NUM("sigquant"), nu, 1, 0)/nu;
+    }
+    cfg.nu=nu;
+    cfg.sigma=sigest;
+    cfg.tau = NA("tau.num") ? (ymax-ymin)/(2.*k*sqrt(cfg.m)) :
+      taunum/(k*sqrt(cfg.m));
+  }
+  else {
+    cfg.lambda=1.;
+    cfg.sigma=1.;
+    cfg.tau=taunum/(k*sqrt(cfg.m));
+  }
+
+  std::vector<double> w(n, 1.), varprob(p, 1./p);
+  unsigned int seed=NUM("seed");
+  arn gen(seed, 2*seed);
+  clisink out(arg["out"], NUM("draws")==1.);
+  if(!gbart(cfg, &x[0], &y[0], np ? &xp[0] : 0, &w[0], &varprob[0], gen, out))
+    return 1;
+  out.finish();
+
+  return 0;
+}
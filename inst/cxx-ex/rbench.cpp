@@ -0,0 +1,240 @@
+/*
+ *  BART: Bayesian Additive Regression Trees
+ *  Copyright (C) 2017 Robert McCulloch and Rodney Sparapani
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-2
+ */
+
+// microbenchmark of the random variate samplers in ../include, e.g.,
+// "make rbench.out" then ./rbench.out N seed
+// for each sampler and parameter setting: ns/draw, rn calls/draw,
+// the rejection rate where each attempt makes one known rn call and
+// the sample mean and variance against the exact values where the
+// z column is the standardized difference of the means
+
+#include <BART3.h>
+#include <BART3/PolyaGamma.h>
+#include <BART3/truncated_norm.h>
+#include <BART3/truncated_gamma.h>
+#include <BART3/inverse_gaussian.h>
+#include <BART3/polyagamma_wrapper.h>
+#include <functional>
+#include <cstdlib>
+
+typedef std::chrono::steady_clock bclock;
+typedef std::function<double(rn&)> sampler;
+
+//counts the calls made through rn: samplers that call Rmath
+//directly (simple_RNG_wrapper.h) are only timed
+class crn: public rn
+{
+ public:
+  crn(rn& _gen):gen(_gen) {reset();}
+  void reset() {nor=0; uni=0; ex=0; other=0;}
+  size_t calls() {return nor+uni+ex+other;}
+  size_t nor, uni, ex, other;
+  virtual double normal() {nor++; return gen.normal();}
+  virtual double uniform() {uni++; return gen.uniform();}
+  virtual double chi_square(double df) {other++; return gen.chi_square(df);}
+  virtual double exp() {ex++; return gen.exp();}
+  virtual double log_gamma(double shape) {other++; return gen.log_gamma(shape);}
+  virtual double gamma(double shape, double rate)
+  {other++; return gen.gamma(shape, rate);}
+  virtual double beta(double a, double b) {other++; return gen.beta(a, b);}
+  virtual size_t discrete() {other++; return gen.discrete();}
+  virtual size_t geometric(double p) {other++; return gen.geometric(p);}
+  virtual void set_wts(std::vector<double>& _wts) {gen.set_wts(_wts);}
+  virtual std::vector<double> log_dirichlet(std::vector<double>& alpha)
+  {other++; return gen.log_dirichlet(alpha);}
+ private:
+  rn& gen;
+};
+
+//attempts of a rejection sampler as counted by crn
+enum {ATT_NONE, ATT_UNIFORM, ATT_NORMAL, ATT_EXP2};
+
+//mean and variance of the density proportional to exp(lf) on [lo, hi]
+//by Simpson's rule
+void nmoments(std::function<double(double)> lf, double lo, double hi,
+	      double& m, double& v)
+{
+  size_t K=20000;
+  double h=(hi-lo)/K, s0=0., s1=0., s2=0.;
+  for(size_t k=0; k<=K; ++k) {
+    double x=lo+k*h, c=(k==0 || k==K) ? 1. : (k%2 ? 4. : 2.), f=c*::exp(lf(x));
+    s0+=f; s1+=f*x; s2+=f*x*x;
+  }
+  m=s1/s0;
+  v=s2/s0-m*m;
+}
+
+//mean and variance of N(mu, sd^2) truncated to (left, infinity)
+void tnmoments(double mu, double sd, double left, double& m, double& v)
+{
+  double a=(left-mu)/sd,
+    l=::exp(-0.5*a*a)/RTPI/(0.5*std::erfc(a/sqrt(2.)));
+  m=mu+sd*l;
+  v=sd*sd*(1.+a*l-l*l);
+}
+
+void bench(const char* name, const char* par, sampler draw, size_t N,
+	   double m, double v, int att, rn& gen)
+{
+  double s1=0., s2=0., x;
+  bclock::time_point tick=bclock::now();
+  for(size_t i=0; i<N; ++i) {
+    x=draw(gen);
+    s1+=x; s2+=x*x;
+  }
+  double ns=1e9*std::chrono::duration<double>(bclock::now()-tick).count()/N;
+  double mhat=s1/N, vhat=s2/N-mhat*mhat;
+
+  size_t Nc=N/10+1; //counts with a shorter run through crn
+  crn cgen(gen);
+  for(size_t i=0; i<Nc; ++i) draw(cgen);
+  double attempts = att==ATT_UNIFORM ? cgen.uni : att==ATT_NORMAL ? cgen.nor :
+    att==ATT_EXP2 ? 0.5*cgen.ex : 0.;
+
+  printf("%-18s %-22s %10.1f %8.2f ", name, par, ns, cgen.calls()/(double)Nc);
+  if(att!=ATT_NONE) printf("%7.4f ", 1.-Nc/attempts);
+  else printf("%7s ", "-");
+  printf("%11.5g %11.5g %11.5g %11.5g", mhat, m, vhat, v);
+  if(v>0.) printf(" %6.2f\n", (mhat-m)/sqrt(v/N));
+  else printf(" %6s\n", "-");
+}
+
+int main(int argc, char** argv) {
+  size_t N = argc>1 ? atol(argv[1]) : 1000000;
+  unsigned int seed = argc>2 ? atol(argv[2]) : 99;
+  arn gen(seed, 2*seed);
+  char par[64];
+  double m, v;
+
+  printf("%-18s %-22s %10s %8s %7s %11s %11s %11s %11s %6s\n", "sampler",
+	 "parameters", "ns/draw", "rn/draw", "reject", "mean", "exact",
+	 "var", "exact", "z");
+
+  //rtnorm: tau is the truncation point, far tails use the exponential
+  double taus[]={-2., 0., 0.5, 2., 5., 10.};
+  for(size_t i=0; i<6; ++i) {
+    double tau=taus[i];
+    tnmoments(0., 1., tau, m, v);
+    sprintf(par, "mean=0,tau=%g,sd=1", tau);
+    bench("rtnorm", par, [tau](rn& g) {return rtnorm(0., tau, 1., g);},
+	  N, m, v, tau<=0. ? ATT_NORMAL : ATT_UNIFORM, gen);
+  }
+
+  //tnorm: standard normal truncated to (left, infinity) or (left, right)
+  double lefts[]={-1., 0.5, 4.};
+  for(size_t i=0; i<3; ++i) {
+    double left=lefts[i];
+    tnmoments(0., 1., left, m, v);
+    sprintf(par, "left=%g", left);
+    bench("tnorm", par, [left](rn& g) {return tnorm(left, g);},
+	  N, m, v, ATT_NONE, gen);
+  }
+  nmoments([](double x) {return -0.5*x*x;}, 1., 1.5, m, v);
+  bench("tnorm", "left=1,right=1.5", [](rn& g) {return tnorm(1., 1.5, g);},
+	N, m, v, ATT_NONE, gen);
+
+  //rtgamma: left truncated gamma with shape>1
+  double rtg[][3]={{2., 1., 1.}, {2., 1., 10.}, {10., 2., 3.}, {10., 2., 10.}};
+  for(size_t i=0; i<4; ++i) {
+    double a=rtg[i][0], b=rtg[i][1], t=rtg[i][2];
+    nmoments([a, b, t](double x) {return (a-1.)*log(x/t)-b*(x-t);},
+	     t, t+(a+40.*sqrt(a)+40.)/b, m, v);
+    sprintf(par, "shape=%g,rate=%g,a=%g", a, b, t);
+    bench("rtgamma", par, [a, b, t](rn& g) {return rtgamma(a, b, t, g);},
+	  N, m, v, ATT_EXP2, gen);
+  }
+
+  //ltgamma and rtgamma_rate (truncated_gamma.h) draw through Rmath
+  for(size_t i=0; i<4; ++i) {
+    double a=rtg[i][0], b=rtg[i][1], t=rtg[i][2];
+    nmoments([a, b, t](double x) {return (a-1.)*log(x/t)-b*(x-t);},
+	     t, t+(a+40.*sqrt(a)+40.)/b, m, v);
+    sprintf(par, "shape=%g,rate=%g,t=%g", a, b, t);
+    bench("ltgamma", par, [a, b, t](rn& g) {return ltgamma(a, b, t);},
+	  N, m, v, ATT_NONE, gen);
+  }
+  for(size_t i=0; i<4; ++i) {
+    double a=rtg[i][0], b=rtg[i][1], t=rtg[i][2];
+    nmoments([a, b, t](double x) {return (a-1.)*log(x/t)-b*(x-t);},
+	     1e-12*t, t, m, v);
+    sprintf(par, "shape=%g,rate=%g,t=%g", a, b, t);
+    bench("rtgamma_rate", par, [a, b, t](rn& g) {return rtgamma_rate(a, b, t);},
+	  N, m, v, ATT_NONE, gen);
+  }
+
+  //inverse Gaussian: mean mu, variance mu^3/lambda
+  double ig[][2]={{1., 1.}, {0.1, 2.}, {5., 0.5}};
+  for(size_t i=0; i<3; ++i) {
+    double mu=ig[i][0], lambda=ig[i][1];
+    sprintf(par, "mu=%g,lambda=%g", mu, lambda);
+    bench("igauss", par, [mu, lambda](rn& g) {return igauss(mu, lambda, g);},
+	  N, mu, pow(mu, 3.)/lambda, ATT_NONE, gen);
+  }
+
+  //Polya-Gamma PG(h, z): rpg_hybrid switches methods by h and builds
+  //a PolyaGamma(1000) each call, PolyaGamma::draw reuses one object
+  PolyaGamma pg(1);
+  double zs[]={0., 2., 10.};
+  for(size_t i=0; i<3; ++i) {
+    double z=zs[i];
+    m=PolyaGamma::pg_m1(1., z);
+    v=PolyaGamma::pg_m2(1., z)-m*m;
+    sprintf(par, "h=1,z=%g", z);
+    bench("PolyaGamma::draw", par, [&pg, z](rn& g) {return pg.draw(1, z, g);},
+	  N, m, v, ATT_NONE, gen);
+  }
+  double hs[]={1., 2., 5., 20., 200.};
+  for(size_t i=0; i<5; ++i) for(size_t j=0; j<2; ++j) {
+    double h=hs[i], z=zs[j];
+    m=PolyaGamma::pg_m1(h, z);
+    v=PolyaGamma::pg_m2(h, z)-m*m;
+    sprintf(par, "h=%g,z=%g", h, z);
+    bench("rpg_hybrid", par, [h, z](rn& g) {double x; rpg_hybrid(x, h, z, g); return x;},
+	  N/100, m, v, ATT_NONE, gen);
+  }
+
+  //lambda: the prior is that of (2K)^2 for K Kolmogorov-Smirnov
+  //so that N(0, lambda) is logistic, mean pi^2/3 and variance 2pi^4/45
+  lambdaprior lp(1000);
+  bench("lambdaprior", "kmax=1000", [&lp](rn& g) {return lp.draw(g);},
+	N, PI*PI/3., 2.*pow(PI, 4.)/45., ATT_NONE, gen);
+  double xbs[]={0., 1., 5.};
+  for(size_t i=0; i<3; ++i) {
+    double xb=xbs[i];
+    sprintf(par, "lambda=1,mean=%g", xb);
+    bench("draw_lambda_i", par, [&lp, xb](rn& g)
+	  {return draw_lambda_i(1., xb, lp, 1, g);}, N/10, 0., 0., ATT_NONE, gen);
+  }
+
+  //log_dirichlet: the first component of exp(draw) is Beta(a_1, sum(a)-a_1)
+  double alphas[]={0.01, 1., 10.};
+  size_t ks[]={10, 100};
+  for(size_t i=0; i<3; ++i) for(size_t j=0; j<2; ++j) {
+    double a=alphas[i];
+    size_t k=ks[j];
+    std::vector<double> alpha(k, a);
+    double A=k*a;
+    sprintf(par, "alpha=%g,k=%zu", a, k);
+    bench("log_dirichlet", par, [alpha](rn& g) mutable
+	  {return ::exp(g.log_dirichlet(alpha)[0]);}, N/k, 1./k,
+	  (a*(A-a))/(A*A*(A+1.)), ATT_NONE, gen);
+  }
+
+  return 0;
+}
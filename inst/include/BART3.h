@@ -33,7 +33,12 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <ctime>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
 
 using std::endl;
 
@@ -44,9 +49,18 @@ using std::endl;
 #ifdef NoRcpp
 
 #include <stdio.h> // for printf
+#include <Rmath.h>
 
 using std::cout;
 
+//the R:: names of the Rmath functions as provided by Rcpp
+namespace R {
+  using ::unif_rand; using ::norm_rand; using ::exp_rand;
+  using ::dnorm; using ::pnorm; using ::pgamma; using ::beta;
+  using ::runif; using ::rnorm; using ::rexp; using ::rgamma; using ::rchisq;
+  using ::rbeta;
+}
+
 #define PI 3.141592653589793238462643383280
 
 #else // YesRcpp
@@ -63,6 +77,7 @@ using std::cout;
 // sqrt(2*pi)
 #define RTPI 2.506628274631000502415765284811
 
+#include <BART3/ckpt.h>
 #include <BART3/rn.h>
 #include <BART3/tree.h>
 #include <BART3/treefuns.h>
@@ -70,11 +85,16 @@ using std::cout;
 #include <BART3/bartfuns.h>
 #include <BART3/bd.h>
 #include <BART3/bart.h>
+#include <BART3/tshape.h>
+#include <BART3/tnodes.h>
 #include <BART3/heterbart.h>
 #include <BART3/rtnorm.h>
 #include <BART3/rtgamma.h>
 #include <BART3/lambda.h>
 #include <BART3/vs.h>
+#include <BART3/gbart.h>
+#include <BART3/forest.h>
+#include <BART3/cutpoints.h>
 
 
 /*
@@ -85,6 +105,7 @@ using std::cout;
 #include "bartfuns.h"
 #include "bd.h"
 #include "bart.h"
+#include "tshape.h"
 #include "heterbart.h"
 #include "rtnorm.h"
 #include "rtgamma.h"
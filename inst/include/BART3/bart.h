@@ -52,20 +52,20 @@ public:
    void setdata(size_t p, size_t n, double *x, double *y, int* nc);
    void setpi(pinfo& pi) {this->pi = pi;}
    void setprior(double alpha, double beta, double tau)
-      {pi.alpha=alpha; pi.mybeta = beta; pi.tau=tau;}
+      {pi.alpha=alpha; pi.mybeta = beta; pi.tau=tau; pi.setpg();}
    void settau(double tau) {pi.tau=tau;}
+   //move probabilities: birth/death, change and swap is the rest
+   void setmoves(double pbd, double pchange) {pi.pbd=pbd; pi.pchange=pchange;}
+   double getpbd() {return pi.pbd;}
+   double getpchange() {return pi.pchange;}
    tree& gettree(size_t i ) { return t[i];}
    void settree(std::string itv) {
      std::stringstream ttss(itv);
      size_t _nd, _m, _p;
      //int _nd, _m, _p;
      ttss >> _nd >> _m >> _p;
-     cout << _nd << ' ' << _m << ' ' << _p << '\n';
-     cout << t.size() << '\n';
-     for(size_t j=0; j<m; j++) {
-       ttss >> t[j];
-       if(j<5) cout << t[j];
-     }
+     for(size_t j=0; j<m; j++) ttss >> t[j];
+     if(allfit) predict(p,n,x,allfit);
    }
    xinfo& getxinfo() {return xi;}
    void setxinfo(xinfo& _xi);
@@ -85,6 +85,12 @@ public:
    void predict(size_t p, size_t n, double *x, double *fp);
    void draw(double sigma, rn& gen);
    double f(size_t i) {return allfit[i];}
+   void setf(size_t i, double f) {allfit[i]=f;}
+   void gettrees(std::vector<bool>& vf, std::vector<size_t>& tix);
+   double predict(double *x, std::vector<size_t>& tix);
+   //checkpoints (ckpt.h): trees, cut points, fit, variable counts and pinfo
+   void save(std::ostream& os);
+   bool load(std::istream& is);
 protected:
   size_t sparse;
   size_t m;  //number of trees
@@ -194,15 +200,24 @@ void bart::setdata(size_t p, size_t n, double *x, double *y, int *nc)
 void bart::predict(size_t p, size_t n, double *x, double *fp)
 //uses: m,t,xi
 {
-   double *fptemp = new double[n];
-
    for(size_t j=0;j<n;j++) fp[j]=0.0;
-   for(size_t j=0;j<m;j++) {
-      fit(t[j],xi,p,n,x,fptemp);
-      for(size_t k=0;k<n;k++) fp[k] += fptemp[k];
-   }
-
-   delete[] fptemp;
+   for(size_t j=0;j<m;j++)
+      for(size_t k=0;k<n;k++) fp[k] += t[j].bn(x+k*p,xi)->gettheta();
+}
+//--------------------------------------------------
+//indices of the trees with a split on a flagged variable
+void bart::gettrees(std::vector<bool>& vf, std::vector<size_t>& tix)
+{
+   tix.clear();
+   for(size_t j=0;j<m;j++) if(t[j].splitson(vf)) tix.push_back(j);
+}
+//--------------------------------------------------
+//sum over the trees in tix at a single x: no allocation
+double bart::predict(double *x, std::vector<size_t>& tix)
+{
+   double fp=0.;
+   for(size_t j=0;j<tix.size();j++) fp += t[tix[j]].bn(x,xi)->gettheta();
+   return fp;
 }
 //--------------------------------------------------
 void bart::draw(double sigma, rn& gen)
@@ -242,4 +257,33 @@ void bart::pr() //print to screen
    else cout << "data not set\n";
 }
 
+//--------------------------------------------------
+void bart::save(std::ostream& os)
+{
+   ckput(os, m); ckput(os, n); ckput(os, p);
+   for(size_t j=0;j<m;j++) t[j].save(os);
+   ckput(os, xi.size());
+   for(size_t j=0;j<xi.size();j++) ckput(os, xi[j]);
+   os.write((const char*)allfit, n*sizeof(double));
+   ckput(os, nv);
+   ckput(os, pv);
+   ckput(os, pi);
+}
+//--------------------------------------------------
+bool bart::load(std::istream& is)
+{
+   size_t _m=0, _n=0, _p=0, k=0;
+   ckget(is, _m); ckget(is, _n); ckget(is, _p);
+   if(!is || _m!=m || _n!=n || _p!=p) return false;
+   for(size_t j=0;j<m;j++) t[j].load(is);
+   ckget(is, k);
+   xi.resize(k);
+   for(size_t j=0;j<k;j++) ckget(is, xi[j]);
+   is.read((char*)allfit, n*sizeof(double));
+   ckget(is, nv);
+   ckget(is, pv);
+   ckget(is, pi);
+   return (bool)is;
+}
+
 #endif
@@ -53,11 +53,18 @@ void allsuff(tree& x, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<size_t>&
 // draw all the bottom node mu's
 void drmu(tree& t, xinfo& xi, dinfo& di, pinfo& pi, double sigma, rn& gen);
 //--------------------------------------------------
-//birth proposal
-void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree::tree_p& nx, size_t& v, size_t& c, double& pr, std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen);
+//birth proposal, the nog nodes of x are found unless given; with aug
+//gen.set_cwts(pv) must be current
+void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree::tree_p& nx, size_t& v, size_t& c, double& pr, std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, tree::npv* nogs=0);
 //--------------------------------------------------
-// death proposal
-void dprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree::tree_p& nx, double& pr, rn& gen);
+// death proposal, the nog nodes of x are found unless given
+void dprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree::tree_p& nx, double& pr, rn& gen, tree::npv* nogs=0);
+//--------------------------------------------------
+//log prior of the rules under top and of its bottom nodes not growing,
+//spv>0 is the sum of pv when the rules are drawn as with aug
+double lsubprior(tree::tree_p top, xinfo& xi, pinfo& pi, std::vector<double>& pv, double spv=0.);
+//add the log prior under n to lp, false if a rule is out of range
+bool lsubprior(tree::tree_p n, xinfo& xi, pinfo& pi, std::vector<double>& pv, double spv, double& lp);
 //--------------------------------------------------
 //draw one mu from post 
 double drawnodemu(size_t n, double sy, double tau, double sigma, rn& gen);
@@ -155,7 +162,7 @@ double lh(size_t n, double sy, double sigma, double tau)
 double pgrow(tree::tree_p n, xinfo& xi, pinfo& pi)
 {
    if(cansplit(n,xi)) {
-      return pi.alpha/pow(1.0+n->depth(),pi.mybeta);
+      return pi.pg(n->depth());
    } else {
       return 0.0;
    }
@@ -224,22 +231,22 @@ void drmu(tree& t, xinfo& xi, dinfo& di, pinfo& pi, double sigma, rn& gen)
 }
 //--------------------------------------------------
 //bprop: function to generate birth proposal
-void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree::tree_p& nx, size_t& v, size_t& c, double& pr, std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen)
+void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree::tree_p& nx, size_t& v, size_t& c, double& pr, std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, tree::npv* nogs)
 {
       //draw bottom node, choose node index ni from list in goodbots
       size_t ni = floor(gen.uniform()*goodbots.size());
       nx = goodbots[ni]; //the bottom node we might birth at
 
       //draw v,  the variable
-      std::vector<size_t> goodvars; //variables nx can split on
+      std::vector<size_t>& ex = nx->getex(xi); //variables nx can NOT split on
+      size_t ngoodvars = xi.size()-ex.size();
       int L,U; //for cutpoint draw
       // Degenerate Trees Strategy (Assumption 2.2)
       if(!aug){
-      getgoodvars(nx,xi,goodvars);
 	gen.set_wts(pv);
 	v = gen.discrete();
 	L=0; U=xi[v].size()-1;
-	if(!std::binary_search(goodvars.begin(),goodvars.end(),v)){ // if variable is bad
+	if(std::binary_search(ex.begin(),ex.end(),v)){ // if variable is bad
 	  c=nx->getbadcut(v); // set cutpoint of node to be same as next highest interior node with same variable
 	}
 	else{ // if variable is good
@@ -250,55 +257,19 @@ void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree
       // Modified Data Augmentation Strategy (Mod. Assumption 2.1)
       // Set c_j = s_j*E[G] = s_j/P{picking a good var}
       // where  G ~ Geom( P{picking a good var} )
+      // the bad vars are ex and the good var is drawn from the cumulative
+      // weights of pv (gen.set_cwts(pv) by the caller: once per sweep in
+      // heterbart::drawt, each call in bd) renormalized without ex
       else{
-	std::vector<size_t> allvars; //all variables
-	std::vector<size_t> badvars; //variables nx can NOT split on
-	std::vector<double> pgoodvars; //vector of goodvars probabilities (from S, our Dirichlet vector draw)
-	std::vector<double> pbadvars; //vector of badvars probabilities (from S,...)
-	getgoodvars(nx,xi,goodvars);
-	//size_t ngoodvars=goodvars.size();
-	size_t nbadvars=0; //number of bad vars
-	double smpgoodvars=0.; //P(picking a good var)
 	double smpbadvars=0.; //P(picking a bad var)
-//	size_t nbaddraws=0; //number of draws at a particular node
-	//this loop fills out badvars, pgoodvars, pbadvars, 
-	//there may be a better way to do this...
-	for(size_t j=0;j<pv.size();j++){
-	  allvars.push_back(j);
-	  if(goodvars[j-nbadvars]!=j) {
-	    badvars.push_back(j);
-	    pbadvars.push_back(pv[j]);
-	    smpbadvars+=pv[j];
-	    nbadvars++;
-	  }
-	  else {
-	    pgoodvars.push_back(pv[j]);
-	    smpgoodvars+=pv[j];
-	  }
-	}
-	//set the weights for variable draw and draw a good variable
-	gen.set_wts(pgoodvars);
-	v = goodvars[gen.discrete()];
-	if(nbadvars!=0){ // if we have bad vars then we need to augment, otherwise we skip
-	  //gen.set_p(smpgoodvars); // set parameter for G
-	  //nbaddraws=gen.geometric(); // draw G = g ~ Geom
-	  // for each bad variable, set its c_j equal to its expected count
-	  /*
-	    gen.set_wts(pbadvars); 
-	  for(size_t k=0;k!=nbaddraws;k++) {
-	    nv[badvars[gen.discrete()]]++;
-	    }
-	  */
-	  for(size_t j=0;j<nbadvars;j++)
-	    nv[badvars[j]]=nv[badvars[j]]+(1/smpgoodvars)*(pv[badvars[j]]/smpbadvars); 	  
-	}
-/*
-      size_t vi = floor(gen.uniform()*goodvars.size()); //index of chosen split variable
-      v = goodvars[vi];
-*/
+	for(size_t j=0;j<ex.size();j++) smpbadvars+=pv[ex[j]];
+	double smpgoodvars=gen.get_cwts_sum()-smpbadvars; //P(picking a good var)
+	v = gen.cdiscrete(ex,smpgoodvars);
+	// for each bad variable, set its c_j equal to its expected count
+	for(size_t j=0;j<ex.size();j++)
+	  nv[ex[j]]=nv[ex[j]]+(1/smpgoodvars)*(pv[ex[j]]/smpbadvars);
 
       //draw c, the cutpoint
-      //int L,U;
       L=0; U = xi[v].size()-1;
       nx->rg(v,&L,&U);
       c = L + floor(gen.uniform()*(U-L+1)); //U-L+1 is number of available split points
@@ -308,22 +279,22 @@ void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree
 
       double Pbotx = 1.0/goodbots.size(); //proposal prob of choosing nx
       size_t dnx = nx->depth();
-      double PGnx = pi.alpha/pow(1.0 + dnx,pi.mybeta); //prior prob of growing at nx
+      double PGnx = pi.pg(dnx); //prior prob of growing at nx
 
       double PGly, PGry; //prior probs of growing at new children (l and r) of proposal
-      if(goodvars.size()>1) { //know there are variables we could split l and r on
-         PGly = pi.alpha/pow(1.0 + dnx+1.0,pi.mybeta); //depth of new nodes would be one more
+      if(ngoodvars>1) { //know there are variables we could split l and r on
+         PGly = pi.pg(dnx+1); //depth of new nodes would be one more
          PGry = PGly;
       } else { //only had v to work with, if it is exhausted at either child need PG=0
          if((int)(c-1)<L) { //v exhausted in new left child l, new upper limit would be c-1
             PGly = 0.0;
          } else {
-            PGly = pi.alpha/pow(1.0 + dnx+1.0,pi.mybeta);
+            PGly = pi.pg(dnx+1);
          }
          if(U < (int)(c+1)) { //v exhausted in new right child r, new lower limit would be c+1
             PGry = 0.0;
          } else {
-            PGry = pi.alpha/pow(1.0 + dnx+1.0,pi.mybeta);
+            PGry = pi.pg(dnx+1);
          }
       }
 
@@ -339,7 +310,7 @@ void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree
       }
 
       double Pnogy; //death prob of choosing the nog node at y
-      size_t nnogs = x.nnogs();
+      size_t nnogs = nogs ? nogs->size() : x.nnogs();
       tree::tree_p nxp = nx->getp();
       if(nxp==0) { //no parent, nx is the top and only node
          Pnogy=1.0;
@@ -355,20 +326,23 @@ void bprop(tree& x, xinfo& xi, pinfo& pi, tree::npv& goodbots, double& PBx, tree
 }
 //--------------------------------------------------
 // death proposal
-void dprop(tree& x, xinfo& xi, pinfo& pi,tree::npv& goodbots, double& PBx, tree::tree_p& nx, double& pr, rn& gen)
+void dprop(tree& x, xinfo& xi, pinfo& pi,tree::npv& goodbots, double& PBx, tree::tree_p& nx, double& pr, rn& gen, tree::npv* nogs)
 {
       //draw nog node, any nog node is a possibility
       tree::npv nognds; //nog nodes
-      x.getnogs(nognds);
-      size_t ni = floor(gen.uniform()*nognds.size());
-      nx = nognds[ni]; //the nog node we might kill children at
+      if(!nogs) {
+         x.getnogs(nognds);
+         nogs = &nognds;
+      }
+      size_t ni = floor(gen.uniform()*nogs->size());
+      nx = (*nogs)[ni]; //the nog node we might kill children at
 
       //--------------------------------------------------
       //compute things needed for metropolis ratio
 
       double PGny; //prob the nog node grows
       size_t dny = nx->depth();
-      PGny = pi.alpha/pow(1.0+dny,pi.mybeta);
+      PGny = pi.pg(dny);
 
       //better way to code these two?
       double PGlx = pgrow(nx->getl(),xi,pi);
@@ -389,11 +363,42 @@ void dprop(tree& x, xinfo& xi, pinfo& pi,tree::npv& goodbots, double& PBx, tree:
       Pboty=1.0/ngood;
 
       double PDx = 1.0-PBx; //prob of a death step at x
-      double Pnogx = 1.0/nognds.size();
+      double Pnogx = 1.0/nogs->size();
 
       pr =  ((1.0-PGny)*PBy*Pboty)/(PGny*(1.0-PGlx)*(1.0-PGrx)*PDx*Pnogx);
 }
 //--------------------------------------------------
+//log prior of the rules under top and of its bottom nodes not growing:
+//a rule is v with prob pv[v] and then c uniform on the range of v as in
+//bprop, -INFINITY if c is outside of that range; with spv>0 (aug) v is
+//drawn from pv without the variables exhausted at the node, whose sum
+//depends on the rules above and so does not cancel in a swap
+double lsubprior(tree::tree_p top, xinfo& xi, pinfo& pi, std::vector<double>& pv, double spv)
+{
+   double lp=0.;
+   return lsubprior(top,xi,pi,pv,spv,lp) ? lp : -INFINITY;
+}
+//the nodes are added in the order of getnodes
+bool lsubprior(tree::tree_p n, xinfo& xi, pinfo& pi, std::vector<double>& pv, double spv, double& lp)
+{
+   if(n->getl()) {
+      size_t v=n->getv();
+      int L=0, U=xi[v].size()-1;
+      n->rg(v,&L,&U);
+      if((int)n->getc()<L || (int)n->getc()>U) return false;
+      lp += log(pv[v]) - log(U-L+1.);
+      if(spv>0.) { //as smpgoodvars in bprop
+         std::vector<size_t>& ex = n->getex(xi);
+         double sgood=spv;
+         for(size_t j=0;j<ex.size();j++) sgood-=pv[ex[j]];
+         lp -= log(sgood);
+      }
+      return lsubprior(n->getl(),xi,pi,pv,spv,lp) && lsubprior(n->getr(),xi,pi,pv,spv,lp);
+   }
+   lp += log(1.0-pgrow(n,xi,pi));
+   return true;
+}
+//--------------------------------------------------
 //draw one mu from post 
 double drawnodemu(size_t n, double sy, double tau, double sigma, rn& gen)
 {
@@ -49,6 +49,7 @@ bool bd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double sigma,
       tree::tree_p nx; //bottom node
       size_t v,c; //variable and cutpoint
       double pr; //part of metropolis ratio from proposal and prior
+      if(aug) gen.set_cwts(pv); //pv may have changed in place since
       bprop(x,xi,pi,goodbots,PBx,nx,v,c,pr,nv,pv,aug,gen);
 
       //--------------------------------------------------
@@ -0,0 +1,67 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+#ifndef GUARD_ckpt_h
+#define GUARD_ckpt_h
+
+//binary checkpoints: values are written as their bytes so that a
+//resumed run is bit-identical, i.e., a checkpoint is only read back
+//on the same platform; vectors are preceded by their length
+
+template<class T> void ckput(std::ostream& os, const T& x)
+{os.write((const char*)&x, sizeof(T));}
+
+template<class T> void ckget(std::istream& is, T& x)
+{is.read((char*)&x, sizeof(T));}
+
+template<class T> void ckput(std::ostream& os, const std::vector<T>& x)
+{
+  size_t k=x.size();
+  ckput(os, k);
+  if(k) os.write((const char*)&x[0], k*sizeof(T));
+}
+
+template<class T> void ckget(std::istream& is, std::vector<T>& x)
+{
+  size_t k=0;
+  ckget(is, k);
+  if(!is) return;
+  x.resize(k);
+  if(k) is.read((char*)&x[0], k*sizeof(T));
+}
+
+inline void ckput(std::ostream& os, const std::string& x)
+{
+  size_t k=x.size();
+  ckput(os, k);
+  os.write(x.data(), k);
+}
+
+inline void ckget(std::istream& is, std::string& x)
+{
+  size_t k=0;
+  ckget(is, k);
+  if(!is) return;
+  x.resize(k);
+  if(k) is.read(&x[0], k);
+}
+
+#endif
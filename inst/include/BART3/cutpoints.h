@@ -0,0 +1,164 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+#ifndef GUARD_cutpoints_h
+#define GUARD_cutpoints_h
+
+//a mergeable quantile sketch of one pass over a variable: level h keeps
+//values of weight 2^h and when it has k of them they are sorted and every
+//other one (alternating the first) moves up a level; so it is exact until
+//k values are added and then the error in rank is about n*log2(n/k)/k
+class qsketch
+{
+  public:
+   qsketch(size_t k=10000):k(k<2 ? 2 : k),n(0) {}
+   size_t getn() const {return n;}
+   bool exact() const {return lev.size()<2;}
+   void add(double x);
+   void merge(const qsketch& s);
+   //the type 7 quantiles of R at the probabilities pr (increasing)
+   void quantile(size_t np, const double *pr, double *q) const;
+  protected:
+   size_t k, n;
+   std::vector< std::vector<double> > lev;
+   std::vector<bool> odd;
+   void compact(size_t h);
+};
+
+void qsketch::add(double x)
+{
+   if(lev.empty()) {lev.resize(1); odd.resize(1,false); lev[0].reserve(k);}
+   lev[0].push_back(x);
+   n++;
+   if(lev[0].size()>=k) compact(0);
+}
+
+void qsketch::compact(size_t h)
+{
+   if(lev.size()==h+1) {lev.resize(h+2); odd.resize(h+2,false);}
+   std::vector<double>& a=lev[h];
+   std::sort(a.begin(),a.end());
+   for(size_t i=(odd[h] ? 1 : 0);i<a.size();i+=2) lev[h+1].push_back(a[i]);
+   odd[h]=!odd[h];
+   a.clear();
+   if(lev[h+1].size()>=k) compact(h+1);
+}
+
+void qsketch::merge(const qsketch& s)
+{
+   if(lev.size()<s.lev.size()) {lev.resize(s.lev.size()); odd.resize(s.lev.size(),false);}
+   for(size_t h=0;h<s.lev.size();h++)
+      lev[h].insert(lev[h].end(),s.lev[h].begin(),s.lev[h].end());
+   n+=s.n;
+   for(size_t h=0;h<lev.size();h++) if(lev[h].size()>=k) compact(h);
+}
+
+void qsketch::quantile(size_t np, const double *pr, double *q) const
+{
+   if(n==0) {for(size_t j=0;j<np;j++) q[j]=NAN; return;}
+   //the values sorted with their weights
+   std::vector< std::pair<double,double> > vw;
+   for(size_t h=0;h<lev.size();h++) {
+      double w=std::ldexp(1.,(int)h);
+      for(size_t i=0;i<lev[h].size();i++) vw.push_back(std::make_pair(lev[h][i],w));
+   }
+   std::sort(vw.begin(),vw.end());
+   //the value of (0-based) rank r: the first with cumulative weight > r,
+   //the ranks only increase with pr so the search goes on from the last
+   size_t i=0; double cw=vw[0].second, N=0.;
+   for(size_t l=0;l<vw.size();l++) N+=vw[l].second;
+   for(size_t j=0;j<np;j++) {
+      double index=1.+(N-1.)*pr[j], lo=std::floor(index), g=index-lo;
+      while(i+1<vw.size() && cw<=lo-1.) cw+=vw[++i].second;
+      double xl=vw[i].first, xh=xl;
+      if(g>0.) {
+	 size_t l=i; double c=cw;
+	 while(l+1<vw.size() && c<=lo) c+=vw[++l].second;
+	 xh=vw[l].first;
+      }
+      q[j]=(g>0. && xh!=xl) ? (1.-g)*xl+g*xh : xl;
+   }
+}
+
+//the cutpoints of bartModelMatrix in one pass over each variable of x
+//(n x p, column major) and in parallel over the variables: with k
+//distinct values, k<2 is constant (nc 1, the value or NAN if k==0),
+//cont or k>=numcut is numcut evenly spaced between the min and max or,
+//if usequants, numcut type 7 quantiles from a qsketch, else k-1 midpoints
+//of the distinct values; NANs are skipped; rm is 1 if constant
+void makecuts(size_t n, size_t p, double *x, size_t numcut, bool usequants,
+	      bool cont, xinfo& xi, std::vector<int>& nc, std::vector<int>& rm,
+	      int tc=1, size_t k=10000)
+{
+   xi.clear(); nc.clear(); rm.clear();
+   if(numcut==0) return;
+   xi.resize(p); nc.assign(p,numcut); rm.assign(p,0);
+   std::vector<double> pr(numcut);
+   for(size_t i=0;i<numcut;i++) pr[i]=(i+1.)/(numcut+1.);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(tc) schedule(dynamic)
+#endif
+   for(size_t j=0;j<p;j++) {
+      double *xj=x+j*n, lo=INFINITY, hi=-INFINITY;
+      //the distinct values while fewer than K, then K means at least K
+      size_t K=numcut<2 ? 2 : numcut;
+      std::vector<double> u;
+      u.reserve(K);
+      bool few=true;
+      qsketch s(usequants ? k : 2);
+      for(size_t i=0;i<n;i++) {
+	 double xx=xj[i];
+	 if(xx!=xx) continue;
+	 if(xx<lo) lo=xx;
+	 if(xx>hi) hi=xx;
+	 if(usequants) s.add(xx);
+	 if(few) {
+	    std::vector<double>::iterator it=std::lower_bound(u.begin(),u.end(),xx);
+	    if(it==u.end() || *it!=xx) {
+	       if(u.size()+1>=K) few=false;
+	       else u.insert(it,xx);
+	    }
+	 }
+      }
+      std::vector<double>& c=xi[j];
+      if(few) K=u.size();
+      if(K<2) {
+	 rm[j]=1; nc[j]=1;
+	 c.assign(1,K==0 ? NAN : lo);
+      }
+      else if(cont || (!few && !usequants)) {
+	 double by=(hi-lo)/(numcut+1.);
+	 c.resize(numcut);
+	 for(size_t i=0;i<numcut;i++) c[i]=lo+(i+1.)*by;
+      }
+      else if(few) {
+	 nc[j]=K-1;
+	 c.resize(K-1);
+	 for(size_t i=0;i<K-1;i++) c[i]=0.5*(u[i]+u[i+1]);
+      }
+      else {
+	 c.resize(numcut);
+	 s.quantile(numcut,&pr[0],&c[0]);
+      }
+   }
+}
+
+#endif
@@ -0,0 +1,338 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+#ifndef GUARD_forest_h
+#define GUARD_forest_h
+
+//the tree draws in flat arrays for the summaries of a fit: the nodes of
+//a tree are in node id order so the children of a branch are adjacent
+//and a tree is walked top down by index, without pointers or recursion
+class forest
+{
+  public:
+   forest():nd(0),m(0),p(0) {}
+   size_t getnd() const {return nd;}
+   size_t getm() const {return m;}
+   size_t getp() const {return p;}
+   //tree j of draw i is the nodes tbeg(i,j),...,tend(i,j)-1
+   size_t tbeg(size_t i, size_t j) const {return beg[i*m+j];}
+   size_t tend(size_t i, size_t j) const {return beg[i*m+j+1];}
+   bool hascover() const {return cover.size()==v.size() && v.size();}
+   //the treedraws string of gbart: nd m p, then the trees as written by
+   //operator<<(tree); the rules get their cutpoint values from xi; cs,
+   //if not 0, is the cover string of the draws (gbartcfg::treecover)
+   bool read(std::istream& is, xinfo& xi, std::istream* cs=0);
+   //append a tree from its nodes in any order, cov may be 0
+   void addtree(std::vector<node_info>& nv, xinfo& xi, double *cov=0);
+   void setdims(size_t nd, size_t m, size_t p);
+   //the number of rows of x (p x n) passing through each node
+   void setcover(size_t n, double *x, int tc=1);
+   //the sum of the trees of draw i at x (p)
+   double predict(size_t i, const double *x) const;
+   //partial dependence: the cover weighted expectation over the variables
+   //not in mask at each of the H rows of xt (H x p, column major), summed
+   //over the trees of each draw into A (nd x H, column major)
+   void expvalue(size_t H, double *xt, int *mask, double *A, int tc=1) const;
+   //TreeSHAP (path dependent, with the covers): the attribution of each
+   //variable at each of the np rows of xp (p x np) summed over the trees
+   //of each draw into phi (nd x np x p, column major); with the cover
+   //weighted mean of the draw they add up to its prediction
+   void shap(size_t np, double *xp, double *phi, int tc=1) const;
+   //nodes
+   std::vector<size_t> id;     //node id
+   std::vector<int> v;         //variable, -1 for a leaf
+   std::vector<size_t> l;      //left child, the right is l+1
+   std::vector<double> c;      //cutpoint value: left if x[v]<c
+   std::vector<double> theta;  //leaf value
+   std::vector<double> cover;  //rows through the node
+  protected:
+   size_t nd, m, p;
+   std::vector<size_t> beg;    //first node of each tree, then the end
+   void expvalue(size_t k, size_t H, double *xt, int *mask, double *wt, double *a) const;
+   //the unique path of TreeSHAP: the variable of a split, the fractions of
+   //the paths through it with the variable out (z) and in (o) of the
+   //coalition, and the weight of the coalitions of each size
+   struct pathel {int v; double z, o, w;};
+   void shap(size_t q, double *x, double *phi, pathel *path, size_t d,
+	     double z, double o, int v) const;
+   static void extendpath(pathel *path, size_t d, double z, double o, int v);
+   static void unwindpath(pathel *path, size_t d, size_t k);
+   static double unwoundsum(const pathel *path, size_t d, size_t k);
+};
+
+//--------------------------------------------------
+void forest::setdims(size_t nd, size_t m, size_t p)
+{
+   this->nd=nd; this->m=m; this->p=p;
+   id.clear(); v.clear(); l.clear(); c.clear(); theta.clear(); cover.clear();
+   beg.assign(1,0);
+   beg.reserve(nd*m+1);
+}
+//--------------------------------------------------
+bool forest::read(std::istream& is, xinfo& xi, std::istream* cs)
+{
+   size_t nd=0, m=0, p=0, nn, cnd=0, cm=0, ck=0, cnn;
+   is >> nd >> m >> p;
+   if(!is || xi.size()<p) return false;
+   if(cs) {
+      *cs >> cnd >> cm >> ck;
+      if(!*cs || cnd!=nd || cm!=m || ck<1) return false;
+   }
+   setdims(nd,m,p);
+   std::vector<node_info> nv;
+   std::vector<double> cov;
+   double b;
+   for(size_t k=0;k<nd*m;k++) {
+      is >> nn;
+      if(!is || nn==0) return false;
+      nv.resize(nn);
+      for(size_t i=0;i<nn;i++)
+	 is >> nv[i].id >> nv[i].v >> nv[i].c >> nv[i].theta;
+      if(!is) return false;
+      if(cs) { //the counts, then the sums of w if ck==2
+	 *cs >> cnn;
+	 if(!*cs || cnn!=nn) return false;
+	 cov.resize(nn);
+	 for(size_t i=0;i<nn;i++) {
+	    *cs >> cov[i];
+	    for(size_t h=1;h<ck;h++) *cs >> b;
+	 }
+	 if(!*cs) return false;
+      }
+      addtree(nv,xi,cs ? &cov[0] : 0);
+   }
+   return true;
+}
+//--------------------------------------------------
+//in node id order the children of the b-th branch are nodes 2b+1 and 2b+2
+void forest::addtree(std::vector<node_info>& nv, xinfo& xi, double *cov)
+{
+   size_t nn=nv.size(), b=beg.back(), k=1;
+   std::vector<size_t> o(nn);
+   for(size_t i=0;i<nn;i++) o[i]=i;
+   for(size_t i=1;i<nn;i++) //insertion sort, few nodes mostly in order
+      for(size_t h=i;h>0 && nv[o[h]].id<nv[o[h-1]].id;h--) std::swap(o[h],o[h-1]);
+   for(size_t i=0;i<nn;i++) {
+      node_info& x=nv[o[i]];
+      id.push_back(x.id);
+      if(k<nn && nv[o[k]].id==2*x.id) { //a branch
+	 v.push_back(x.v);
+	 l.push_back(b+k);
+	 c.push_back(xi[x.v][x.c]);
+	 k+=2;
+      }
+      else {
+	 v.push_back(-1);
+	 l.push_back(0);
+	 c.push_back(0.);
+      }
+      theta.push_back(x.theta);
+      if(cov) cover.push_back(cov[o[i]]);
+   }
+   beg.push_back(b+nn);
+}
+//--------------------------------------------------
+void forest::setcover(size_t n, double *x, int tc)
+{
+   cover.assign(v.size(),0.);
+   size_t K=nd*m;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(tc) schedule(dynamic)
+#endif
+   for(size_t k=0;k<K;k++) {
+      size_t b=beg[k];
+      if(beg[k+1]==b+1) {cover[b]=n; continue;} //a stump
+      for(size_t i=0;i<n;i++) {
+	 double *xx=x+i*p;
+	 size_t q=b;
+	 cover[q]++;
+	 while(v[q]>=0) {
+	    q = xx[v[q]]<c[q] ? l[q] : l[q]+1;
+	    cover[q]++;
+	 }
+      }
+   }
+}
+//--------------------------------------------------
+//the trees are added in order as by fit in bart::predict
+double forest::predict(size_t i, const double *x) const
+{
+   double f=0.;
+   for(size_t k=i*m;k<(i+1)*m;k++) {
+      size_t q=beg[k];
+      while(v[q]>=0) q = x[v[q]]<c[q] ? l[q] : l[q]+1;
+      f += theta[q];
+   }
+   return f;
+}
+//--------------------------------------------------
+void forest::expvalue(size_t H, double *xt, int *mask, double *A, int tc) const
+{
+   size_t nn=1;
+   for(size_t k=0;k<nd*m;k++) nn=std::max(nn,beg[k+1]-beg[k]);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(tc)
+#endif
+   {
+      std::vector<double> wt(nn*H), a(H);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for(size_t i=0;i<nd;i++) {
+	 for(size_t h=0;h<H;h++) a[h]=0.;
+	 for(size_t j=0;j<m;j++) expvalue(i*m+j,H,xt,mask,&wt[0],&a[0]);
+	 for(size_t h=0;h<H;h++) A[i+h*nd]=a[h];
+      }
+   }
+}
+//--------------------------------------------------
+//one pass over the nodes of tree k for all H rows: wt is the probability
+//of each row reaching each node, which a rule on a variable in mask sends
+//one way and any other rule splits as the covers of the children
+void forest::expvalue(size_t k, size_t H, double *xt, int *mask, double *wt, double *a) const
+{
+   size_t b=beg[k], e=beg[k+1];
+   for(size_t h=0;h<H;h++) wt[h]=1.;
+   for(size_t q=b;q<e;q++) {
+      double *w=wt+(q-b)*H;
+      if(v[q]<0) {
+	 for(size_t h=0;h<H;h++) a[h] += w[h]*theta[q];
+	 continue;
+      }
+      double *wl=wt+(l[q]-b)*H, *wr=wl+H;
+      if(mask[v[q]]) {
+	 double *xv=xt+v[q]*H;
+	 for(size_t h=0;h<H;h++) {
+	    bool left = xv[h]<c[q];
+	    wl[h] = left ? w[h] : 0.;
+	    wr[h] = left ? 0. : w[h];
+	 }
+      }
+      else {
+	 double cl=cover[l[q]], cr=cover[l[q]+1];
+	 double fl = cl+cr>0. ? cl/(cl+cr) : .5; //no rows: an even split
+	 for(size_t h=0;h<H;h++) {
+	    wl[h] = w[h]*fl;
+	    wr[h] = w[h]-wl[h];
+	 }
+      }
+   }
+}
+//--------------------------------------------------
+//TreeSHAP: Lundberg, Erion and Lee (2018) arXiv:1802.03888, Algorithm 2
+void forest::shap(size_t np, double *xp, double *phi, int tc) const
+{
+   size_t dmax=0, N=nd*np;
+   for(size_t q=0;q<id.size();q++) {
+      size_t d=0;
+      for(size_t k=id[q];k>1;k/=2) d++;
+      dmax=std::max(dmax,d);
+   }
+   size_t nps=(dmax+2)*(dmax+3)/2; //a path for each depth of the recursion
+#ifdef _OPENMP
+#pragma omp parallel num_threads(tc)
+#endif
+   {
+      std::vector<pathel> path(nps);
+      std::vector<double> f(p);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for(size_t ik=0;ik<N;ik++) { //draw i, row k
+	 size_t i=ik%nd, k=ik/nd;
+	 for(size_t j=0;j<p;j++) f[j]=0.;
+	 for(size_t j=0;j<m;j++) shap(beg[i*m+j],xp+k*p,&f[0],&path[0],0,1.,1.,-1);
+	 for(size_t j=0;j<p;j++) phi[ik+j*N]=f[j];
+      }
+   }
+}
+//--------------------------------------------------
+//node q is reached with the path of its parent (length d) extended by
+//the parent's split on v; a leaf adds its share to each variable on it
+void forest::shap(size_t q, double *x, double *phi, pathel *path, size_t d,
+		  double z, double o, int v) const
+{
+   pathel *up=path+d+1; //this node's copy of the path
+   std::copy(path,path+d+1,up);
+   extendpath(up,d,z,o,v);
+   if(this->v[q]<0) {
+      for(size_t i=1;i<=d;i++)
+	 phi[up[i].v] += unwoundsum(up,d,i)*(up[i].o-up[i].z)*theta[q];
+      return;
+   }
+   size_t hot = x[this->v[q]]<c[q] ? l[q] : l[q]+1;
+   size_t cold = hot==l[q] ? l[q]+1 : l[q];
+   double zh=.5, zc=.5, iz=1., io=1.;
+   if(cover[q]>0.) {zh=cover[hot]/cover[q]; zc=cover[cold]/cover[q];}
+   size_t k=1;
+   for(;k<=d;k++) if(up[k].v==this->v[q]) break;
+   if(k<=d) { //v was split on above: undo it to redo it here
+      iz=up[k].z; io=up[k].o;
+      unwindpath(up,d,k);
+      d--;
+   }
+   shap(hot,x,phi,up,d+1,zh*iz,io,this->v[q]);
+   shap(cold,x,phi,up,d+1,zc*iz,0.,this->v[q]);
+}
+//--------------------------------------------------
+void forest::extendpath(pathel *path, size_t d, double z, double o, int v)
+{
+   path[d].v=v; path[d].z=z; path[d].o=o;
+   path[d].w = d==0 ? 1. : 0.;
+   for(size_t i=d;i>0;i--) {
+      path[i].w += o*path[i-1].w*i/(d+1.);
+      path[i-1].w = z*path[i-1].w*(d-i+1)/(d+1.);
+   }
+}
+//--------------------------------------------------
+//remove element k from the path of length d+1
+void forest::unwindpath(pathel *path, size_t d, size_t k)
+{
+   double o=path[k].o, z=path[k].z, n=path[d].w, t;
+   for(size_t i=d;i>0;i--) {
+      if(o!=0.) {
+	 t=path[i-1].w;
+	 path[i-1].w = n*(d+1.)/(i*o);
+	 n = t-path[i-1].w*z*(d-i+1)/(d+1.);
+      }
+      else path[i-1].w = path[i-1].w*(d+1.)/(z*(d-i+1));
+   }
+   for(size_t i=k;i<d;i++) {
+      path[i].v=path[i+1].v; path[i].z=path[i+1].z; path[i].o=path[i+1].o;
+   }
+}
+//--------------------------------------------------
+//the total weight of the path with element k removed
+double forest::unwoundsum(const pathel *path, size_t d, size_t k)
+{
+   double o=path[k].o, z=path[k].z, n=path[d].w, t, s=0.;
+   for(size_t i=d;i>0;i--) {
+      if(o!=0.) {
+	 t = n*(d+1.)/(i*o);
+	 s += t;
+	 n = path[i-1].w-t*z*(d-i+1)/(d+1.);
+      }
+      else if(z!=0.) s += path[i-1].w*(d+1.)/(z*(d-i+1));
+   }
+   return s;
+}
+
+#endif
@@ -0,0 +1,653 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+#ifndef GUARD_gbart_h
+#define GUARD_gbart_h
+
+//the gbart MCMC engine with a plain C++ interface: settings in a
+//gbartcfg, data as arrays and the draws handed to a gbartsink as
+//they are made; cgbart is a wrapper of this for R
+
+//--------------------------------------------------
+//settings: the defaults are those of gbart in R
+struct gbartcfg
+{
+  gbartcfg():type(1),n(0),p(0),np(0),m(200),nd(1000),burn(100),thin(1),
+    power(2.),base(0.95),Offset(0.),tau(0.),nu(3.),lambda(0.),sigma(1.),
+    sparse(1),a(0.5),b(1.),rho(0.),theta(0.),omega(1.),aug(false),
+    an(Eigen::MatrixXd::Zero(1, 1)),noan(0),bprvar(0.),tprprm(0.),
+    pbd(1.),pchange(0.),adapt(false),
+    printevery(100),diagevery(0),treeshape(false),treecover(0),shards(1),
+    checkevery(0) {}
+  int type;             //1:wbart, 2:pbart, 3:lbart, 4:pgbart
+  size_t n, p, np;      //train and test observations, dimension of x
+  size_t m;             //number of trees
+  size_t nd, burn, thin;//kept draws (before thinning), burn-in and thinning
+  double power, base;   //tree prior
+  double Offset, tau;   //f(x)=Offset+sum of trees, sd of the leaves
+  double nu, lambda;    //sigma^2 prior: lambda==0 holds sigma fixed
+  double sigma;         //initial sigma (type==1)
+  size_t sparse;        //1: off, 2: DART, 3: logit-normal, 4: LN LASSO
+  double a, b, rho, theta, omega; //DART
+  bool aug;             //categorical strategy: data augment or not
+  Eigen::MatrixXd an;   //logit-normal annotations
+  size_t noan;          //number of annotations
+  double bprvar, tprprm;//logit-normal beta variance and tau^2 scale
+  std::vector<int> numcut; //number of cut points for each variable
+  xinfo xi;             //cut points: empty for a uniform grid
+  std::string trees;    //initial trees as written by the tree draws
+  double pbd, pchange;  //move probabilities: birth/death, change and swap is the rest
+  bool adapt;           //adapt the move probabilities during burn-in
+  size_t printevery;
+  size_t diagevery;     //diagnostics every diagevery iterations, 0: none
+  bool treeshape;       //depth and leaves of each tree with the tree draws
+  int treecover;        //with the tree draws: the train rows at each node
+                        //(1) and their sum of w (2), 0: none
+  int shards;
+  //imputation of a categorical covariate coded as K indicator columns
+  std::vector<int> impute_mult;   //length K: the indicator columns
+  std::vector<int> impute_miss;   //length n: 1 missing, 2 copy the row above
+  std::vector<double> impute_prior; //n x K column-major prior probabilities
+  //binary checkpoint of the MCMC state every checkevery iterations
+  //(0: none) and/or the checkpoint to resume from: a resumed run
+  //only produces the draws after the checkpoint
+  std::string checkpoint, resume;
+  size_t checkevery;
+  size_t nkeep() const {return nd/thin;}
+  size_t ndiag() const {return diagevery ? (nd+burn)/diagevery : 0;}
+  //kept draws and diagnostics of the iterations before i
+  size_t nkept(size_t i) const {return i>burn ? std::min((i-burn)/thin, nkeep()) : 0;}
+  size_t ndiags(size_t i) const {return diagevery ? std::min(i/diagevery, ndiag()) : 0;}
+};
+
+//--------------------------------------------------
+//receives the draws: the default methods discard them
+class gbartsink
+{
+ public:
+  virtual ~gbartsink() {}
+  //called once before the MCMC which begins at iteration start (0
+  //unless resumed) and then with the cut points in use; this one keeps
+  //the sizes of the draws so a sink that overrides it calls it first
+  virtual void init(const gbartcfg& cfg, size_t start) {
+    n=cfg.n; np=cfg.np; m=cfg.m; p=cfg.p; this->start=start;
+    nsigma=cfg.nd+cfg.burn-start;
+    nkeep=cfg.nkeep()-cfg.nkept(start);
+    ndiag=cfg.ndiag()-cfg.ndiags(start);
+    treeshape=cfg.treeshape;
+    treecover=cfg.treecover;
+  }
+  virtual void cutpoints(xinfo& xi) {}
+  //draws are numbered from start: the ith sigma (type==1 and
+  //lambda!=0) is of iteration start+i and the dth kept draw is the
+  //(cfg.nkept(start)+d)th of the run
+  virtual void sigma(size_t i, double s) {}
+  //kept draw d: f(x) for the n train or np test rows
+  virtual void train(size_t d, const double* f) {}
+  virtual void test(size_t d, const double* f) {}
+  //kept draw d: the imputed first two indicators (2 if not imputed)
+  virtual void impute(size_t d, const double* x1, const double* x2) {}
+  //kept draw d: the trees, variable counts and probabilities
+  virtual void trees(size_t d, heterbart& bm) {}
+  //diagnostics g: seconds per phase (tree, latent, varsel, sigma,
+  //impute, test, treedraws) then birth/death proposed/accepted
+  virtual void diag(size_t g, const double* dg, heterbart& bm) {}
+  //from init: the sizes of the data and of the draws from start, i.e.,
+  //the sigmas, the kept draws and the diagnostics
+  size_t n, np, m, p, start, nsigma, nkeep, ndiag;
+  bool treeshape;
+  int treecover;
+};
+
+//the header lines of the tree and cover strings of the kept draws
+void putheaders(std::ostream& treess, std::ostream& coverss,
+		const gbartsink& out)
+{
+  treess.precision(10);
+  treess << out.nkeep << " " << out.m << " " << out.p << endl;
+  if(out.treecover) {
+    coverss.precision(10);
+    coverss << out.nkeep << " " << out.m << " " << out.treecover << endl;
+  }
+}
+
+//the covers of the trees of a kept draw (gbartcfg::treecover k): for
+//each tree a line of its number of nodes then the count, and if k==2
+//the sum of w, of each node in the order of the tree draws
+void putcover(std::ostream& os, heterbart& bm, int k)
+{
+  std::vector<double> cn, cb;
+  for(size_t j=0; j<bm.getm(); j++) {
+    bm.getcover(j, cn, cb);
+    os << cn.size();
+    for(size_t q=0; q<cn.size(); q++) {
+      os << " " << cn[q];
+      if(k==2) os << " " << cb[q];
+    }
+    os << endl;
+  }
+}
+
+//keeps all of the draws in memory as cgbart does: matrices are
+//row-major with a row per draw and the trees are in the format of
+//bart::settree and read.trees
+class gbartdraws: public gbartsink
+{
+ public:
+  virtual void init(const gbartcfg& cfg, size_t start) {
+    gbartsink::init(cfg, start);
+    sdraw.assign(nsigma, 0.);
+    trdraw.assign(nkeep*n, 0.);
+    tedraw.assign(nkeep*np, 0.);
+    if(cfg.impute_mult.size()>0) {
+      impute1.assign(nkeep*n, 0.);
+      impute2.assign(nkeep*n, 0.);
+    }
+    varcnt.assign(nkeep*p, 0);
+    varprb.assign(nkeep*p, 0.);
+    diagnostics.assign(ndiag*11, 0.);
+    shdepth.assign(ndiag*11, 0);
+    shleaves.assign(ndiag*32, 0);
+    dhist.resize(11);
+    lhist.resize(32);
+    if(treeshape) {
+      trdepth.assign(nkeep*m, 0);
+      trleaves.assign(nkeep*m, 0);
+    }
+    treess.str("");
+    coverss.str("");
+    putheaders(treess, coverss, *this);
+  }
+  virtual void cutpoints(xinfo& _xi) {xi=_xi;}
+  virtual void sigma(size_t i, double s) {sdraw[i]=s;}
+  virtual void train(size_t d, const double* f)
+  {std::copy(f, f+n, &trdraw[d*n]);}
+  virtual void test(size_t d, const double* f)
+  {std::copy(f, f+np, &tedraw[d*np]);}
+  virtual void impute(size_t d, const double* x1, const double* x2) {
+    std::copy(x1, x1+n, &impute1[d*n]);
+    std::copy(x2, x2+n, &impute2[d*n]);
+  }
+  virtual void trees(size_t d, heterbart& bm) {
+    std::vector<size_t>& nv=bm.getnv();
+    std::vector<double>& pv=bm.getpv();
+    for(size_t j=0; j<m; j++) treess << bm.gettree(j);
+    if(treecover) putcover(coverss, bm, treecover);
+    for(size_t j=0; j<p; j++) {
+      varcnt[d*p+j]=nv[j];
+      varprb[d*p+j]=pv[j];
+    }
+    if(treeshape) {
+      tshape& ts=bm.getts();
+      for(size_t j=0; j<m; j++) {
+	trdepth[d*m+j]=ts.depth(j);
+	trleaves[d*m+j]=ts.nbots(j);
+      }
+    }
+  }
+  virtual void diag(size_t g, const double* dg, heterbart& bm) {
+    std::copy(dg, dg+11, &diagnostics[g*11]);
+    bm.getts().hist(dhist, lhist);
+    for(size_t j=0; j<11; j++) shdepth[g*11+j]=dhist[j];
+    for(size_t j=0; j<32; j++) shleaves[g*32+j]=lhist[j];
+  }
+  std::vector<double> sdraw, trdraw, tedraw, impute1, impute2, varprb,
+    diagnostics;
+  std::vector<size_t> varcnt, shdepth, shleaves, trdepth, trleaves;
+  std::stringstream treess, coverss;
+  xinfo xi;
+ private:
+  std::vector<size_t> dhist, lhist;
+};
+
+//--------------------------------------------------
+//x is pxn and xp is pxnp (transposed so rows are contiguous in memory),
+//imputation overwrites the indicator columns of x; y is centered by
+//Offset for type 1 and 0/1 otherwise; w is the sd of y for type 1 and
+//of the latent for types 2 and 3; varprob is the initial variable
+//selection probabilities; returns false if cfg.resume can't be used
+bool gbart(const gbartcfg& cfg, double* ix, double* iy, double* ixp,
+	   double* iw, double* varprob, rn& gen, gbartsink& out)
+{
+   int type=cfg.type, shards=cfg.shards;
+   size_t n=cfg.n, p=cfg.p, np=cfg.np, m=cfg.m, nd=cfg.nd, burn=cfg.burn,
+     thin=cfg.thin, sparse=cfg.sparse, noan=cfg.noan;
+   double Offset=cfg.Offset, nu=cfg.nu, lambda=cfg.lambda, sigma=cfg.sigma;
+   std::vector<int> numcut=cfg.numcut;
+   size_t nkeeptrain=cfg.nkeep(), nkeeptest=cfg.nkeep(),
+     nkeeptreedraws=cfg.nkeep(), printevery=cfg.printevery,
+     diagevery=cfg.diagevery, ndiag=cfg.ndiag();
+   const std::vector<int>& impute_mult=cfg.impute_mult;
+   const std::vector<int>& impute_miss=cfg.impute_miss;
+   size_t K=impute_mult.size(); // number of columns to impute
+   const double *impute_prior_ptr = K>0 ? &cfg.impute_prior[0] : 0;
+   std::vector<double> impute_post(K); // posterior imputation probability
+
+   heterbart bm(m);
+   if(cfg.xi.size()>0) {
+     xinfo _xi=cfg.xi;
+     bm.setxinfo(_xi);
+   }
+
+   printf("*****Calling gbart: type=%d\n", type);
+
+   size_t skiptr=thin, skipte=thin, skiptreedraws=thin;
+
+   //--------------------------------------------------
+   //print args
+   printf("*****Data:\n");
+   printf("n,p,np: %zu, %zu, %zu\n",n,p,np);
+   printf("y1,yn: %lf, %lf\n",iy[0],iy[n-1]);
+   printf("x1,x[n*p]: %lf, %lf\n",ix[0],ix[n*p-1]);
+   if(np) printf("xp1,xp[np*p]: %lf, %lf\n",ixp[0],ixp[np*p-1]);
+   printf("*****Number of Trees: %zu\n",m);
+   printf("*****Number of Cut Points: %d ... %d\n", numcut[0], numcut[p-1]);
+   printf("*****burn,nd,thin: %zu,%zu,%zu\n",burn,nd,thin);
+   printf("*****Value of treeinit: %d\n", cfg.trees.size()>0);
+   cout << "*****Prior:beta,alpha,tau,nu,lambda,offset,shards:\n"
+	<< cfg.power << ',' << cfg.base << ',' << cfg.tau << ','
+        << nu << ',' << lambda << ',' << Offset << ',' << shards << endl;
+   printf("*****Moves:birth/death,change,swap,adapt: %g,%g,%g,%d\n",
+	  cfg.pbd,cfg.pchange,1.-cfg.pbd-cfg.pchange,cfg.adapt);
+if(type==1) {
+   printf("*****sigma: %lf\n",sigma);
+   printf("*****w (weights): %lf ... %lf\n",iw[0],iw[n-1]);
+}
+   if(K>0) {
+     cout << "*****Missing imputation row indices:\n index 0=" << impute_miss[0] << ','
+	  << "index n-1=" << impute_miss[n-1] << endl;
+     cout << "*****Missing imputation column indices:\n index 0=" << impute_mult[0] << ','
+	  << "index K-1=" << impute_mult[K-1] << endl;
+   }
+   if(sparse==1) cout << "*****Variable Selection: traditional BART\ns[0], ..., s[p-1]:" << endl << varprob[0] << "..." << varprob[p-1] << endl;
+   else if(sparse==2) cout << "*****Variable Selection: Dirichlet prior\ntheta,a,b,rho" << cfg.theta << ',' << cfg.a << ',' << cfg.b << ',' << cfg.rho << endl;
+   else if(sparse==3 && noan==0) cout << "*****Variable Selection: Logit-normal prior w/o Annotations\n beta prior variance, tau^2 scale parameter:" << endl << cfg.bprvar << ',' << cfg.tprprm << endl;
+   else if(sparse==3 && noan!=0) cout << "*****Variable Selection: Logit-normal prior w/ Annotations\n beta prior variance, tau^2 scale parameter, number of annotations:" << endl << cfg.bprvar << ',' << cfg.tprprm << ',' << noan << endl;
+      else if(sparse==4 && noan!=0) cout << "*****Variable Selection: Logit-normal prior w/ Annotations LASSO\n beta prior variance, tau^2 scale parameter, number of annotations:" << endl << cfg.bprvar << ',' << cfg.tprprm << ',' << noan << endl;
+   //--------------------------------------------------
+   //create temporaries
+   double df=n+nu;
+   std::vector<double> z(n), wvec(n); //wvec: precisions, scaled by bm.getwscale()
+   std::vector<double> sign(type!=1 ? n : 0);
+   std::vector<double> lam, lmean; //type==3: latent variances and their means
+   lambdaprior lprior(1000);
+   PolyaGamma pgdraw(1); //type==4: PG(1, f) latent precisions
+   if(type==3) {
+     lam.resize(n);
+     lmean.resize(n);
+   }
+   std::vector<int> prevXV(p);
+   //impute: rows to impute, trees that split on impute_mult and workspace
+   std::vector<size_t> impute_rows, impute_tix;
+   std::vector<bool> impute_vf(p, false);
+   std::vector<double> impute_base, impute_fhat, impute_wt;
+   if(K>0) {
+     for(size_t i=0; i<n; i++) if(impute_miss[i]==1) impute_rows.push_back(i);
+     for(size_t j=0; j<K; j++) impute_vf[impute_mult[j]]=true;
+     impute_base.resize(impute_rows.size());
+     impute_fhat.resize(impute_rows.size()*K);
+     impute_wt.resize(impute_rows.size()*K);
+     impute_tix.reserve(m);
+   }
+
+   for(size_t i=0; i<n; i++) {
+     double *xi=&ix[i*p];
+     if(type==1) {
+       wvec[i] = 1./(iw[i]*iw[i]);
+       z[i] = iy[i];
+     }
+     else {
+       wvec[i] = 1./(iw[i]*iw[i]);
+       if(iy[i]==0) sign[i] = -1.;
+       else sign[i] = 1.;
+       z[i] = sign[i];
+       if(type==3) lam[i] = iw[i]*iw[i];
+       else if(type==4) { //start at the PG(1, 0) mean of 1/4
+	 wvec[i] = 0.25;
+	 z[i] = 2.*sign[i]-Offset;
+       }
+     }
+     if(K>0) {
+       if(impute_miss[i]==1) {
+	 for(size_t j=0; j<K; j++) {
+	   xi[impute_mult[j]]=0;
+	   prevXV[impute_mult[j]]=0;
+	   impute_post[j]=impute_prior_ptr[i+j*n];
+	 }
+	 gen.set_wts(impute_post);
+	 size_t k=gen.discrete(); // use prior prob only
+	 xi[impute_mult[k]]=1;
+	 prevXV[impute_mult[k]]=1;
+       }
+       else if(impute_miss[i]==2)
+	 for(size_t j=0; j<K; j++)
+	   xi[impute_mult[j]]=prevXV[impute_mult[j]];
+     }
+   }
+   //--------------------------------------------------
+   //set up BART model
+   bm.setprior(cfg.base,cfg.power,cfg.tau);
+   bm.setmoves(cfg.pbd,cfg.pchange);
+   bm.setaug(cfg.aug);
+   bm.setcover(cfg.treecover>0);
+   bm.setdata(p,n,ix,&z[0],&numcut[0]);
+   //wbart and pbart keep wvec, the others redraw it each iteration
+   bool unitw = type<=2;
+   for(size_t i=0; unitw && i<n; i++) unitw = wvec[i]==1.;
+   bm.setw(&wvec[0],unitw);
+   if(type==1) bm.setwscale(1./(sigma*sigma));
+   vs varsel(sparse,p);
+   if(sparse==2) varsel.setvs_dart(cfg.a,cfg.b,false,cfg.rho,cfg.theta,0.);
+   else if(sparse==3) varsel.setvs_ln(cfg.bprvar,cfg.tprprm,cfg.an,noan,false,gen);
+   else if(sparse==4) varsel.setvs_ln(cfg.bprvar,cfg.tprprm,cfg.an,noan,true,gen);
+   bm.setpv(varprob);
+   if(cfg.trees.size()>0) bm.settree(cfg.trees);
+   //the test rows' bottom nodes are followed through the moves unless
+   //that takes more than 128MB, i.e., m*np pointers
+   bool testnodes = np && nkeeptest && m*np<=((size_t)1<<24);
+   if(testnodes) bm.settest(np,ixp);
+
+   // dart iterations
+   std::vector<double> ivarprb=bm.getpv();
+
+   //moves proposed and accepted in this window of burn-in: birth/death,
+   //change and swap
+   const size_t adaptevery=100;
+   std::vector<size_t> mvcnt(6, 0);
+
+   //log variable probabilities drawn by varsel
+   std::vector<double> lpv(p, 0.);
+
+   //--------------------------------------------------
+   //resume: the latents, imputed columns and the state of the
+   //variable selection, trees and generator at iteration start
+   const char *ckmagic="BART3 gbart checkpoint 3";
+   size_t start=0;
+   if(cfg.resume.size()>0) {
+     std::ifstream ck(cfg.resume.c_str(), std::ios::binary);
+     std::string magic;
+     int cktype=0;
+     size_t ckK=0;
+     std::vector<double> ximp;
+     ckget(ck, magic);
+     ckget(ck, cktype);
+     ckget(ck, ckK);
+     ckget(ck, start);
+     bool ok = ck && magic==ckmagic && cktype==type && ckK==K && start<=nd+burn;
+     if(ok) {
+       ckget(ck, sigma);
+       ckget(ck, z);
+       ckget(ck, wvec);
+       ckget(ck, lam);
+       ckget(ck, prevXV);
+       ckget(ck, ximp);
+       ckget(ck, ivarprb);
+       ckget(ck, mvcnt);
+       ok = ck && z.size()==n && wvec.size()==n && ximp.size()==n*K &&
+	 ivarprb.size()==p && mvcnt.size()==6 && varsel.load(ck) && bm.load(ck);
+       if(ok) gen.load(ck);
+       ok = ok && ck;
+       if(ok) for(size_t i=0; i<n; i++)
+	 for(size_t j=0; j<K; j++) ix[i*p+impute_mult[j]]=ximp[i*K+j];
+     }
+     if(!ok) {
+       printf("*****Can't resume from checkpoint: %s\n", cfg.resume.c_str());
+       return false;
+     }
+     bm.setpv(&ivarprb[0]);
+     printf("*****Resuming from checkpoint at iteration %zu\n", start);
+   }
+   out.init(cfg, start);
+   out.cutpoints(bm.getxinfo());
+
+   //--------------------------------------------------
+   //temporary storage
+   //in and out of sample fit
+   std::vector<double> fhattrain(n), fhattest(np);
+   std::vector<double> impute_draw1(K>0 ? n : 0), impute_draw2(K>0 ? n : 0);
+
+   //--------------------------------------------------
+   //mcmc
+   printf("\nMCMC\n");
+   size_t trcnt=0; //count kept train draws
+   size_t tecnt=0; //count kept test draws
+   bool keeptest,keeptreedraw,
+     type1sigest=(type==1 && lambda!=0.);
+
+   time_t tp;
+   int time1 = time(&tp);
+   size_t total=nd+burn;
+
+   //diagnostics: seconds per phase (tree, latent, varsel, sigma,
+   //impute, test, treedraws) then birth/death proposed/accepted
+   typedef std::chrono::steady_clock dclock;
+   dclock::time_point tick, tock;
+   double dtime[7]={0., 0., 0., 0., 0., 0., 0.}, dg[11];
+   size_t dgcnt=cfg.ndiags(start); //count recorded diagnostics
+   cinfo& ci = bm.getci();
+#define DLAP(j) tock=dclock::now(); \
+   dtime[j]+=std::chrono::duration<double>(tock-tick).count(); tick=tock
+
+   for(size_t i=start;i<total;i++) {
+      if(i%printevery==0) printf("done %zu (out of %lu)\n",i,nd+burn);
+      if(i==(burn/2)) varsel.turn_on();
+      //draw bart
+      tick=dclock::now();
+      cinfo ci0=ci;
+      bm.draw(gen,shards);
+      DLAP(0);
+      if(cfg.adapt && i<burn) {
+	mvcnt[0]+=ci.bprop+ci.dprop-ci0.bprop-ci0.dprop;
+	mvcnt[1]+=ci.bacc+ci.dacc-ci0.bacc-ci0.dacc;
+	mvcnt[2]+=ci.cprop-ci0.cprop; mvcnt[3]+=ci.cacc-ci0.cacc;
+	mvcnt[4]+=ci.sprop-ci0.sprop; mvcnt[5]+=ci.sacc-ci0.sacc;
+	if((i+1)%adaptevery==0) {
+	  //half of the probability of each move is as given and half
+	  //is shared in proportion to it times its acceptance rate;
+	  //frozen after burn-in so the kept draws are from a fixed kernel
+	  double p0[3]={cfg.pbd, cfg.pchange, 1.-cfg.pbd-cfg.pchange}, q[3], sq=0.;
+	  for(size_t k=0; k<3; k++) {
+	    q[k] = mvcnt[2*k] ? p0[k]*mvcnt[2*k+1]/(double)mvcnt[2*k] : 0.;
+	    sq+=q[k];
+	  }
+	  if(sq>0.) bm.setmoves(0.5*(p0[0]+q[0]/sq), 0.5*(p0[1]+q[1]/sq));
+	  std::fill(mvcnt.begin(), mvcnt.end(), 0);
+	}
+      }
+      std::vector<size_t>& nv = bm.getnv();
+      if(varsel.is_on()) {
+        size_t R=0;
+        for(size_t j=0;j<p;j++) R+=nv[j];
+        varsel.set_R(R);
+        if(varsel.get_sparse()==2){
+          varsel.draw_s_dart(lpv,nv,gen);
+          varsel.draw_theta0_dart(lpv,gen);
+        }
+        else if(varsel.get_sparse()==3){
+          varsel.draw_s_ln(nv,lpv,gen);
+          varsel.draw_tau2_ln(gen);
+        }
+        else if(varsel.get_sparse()==4){
+          varsel.draw_s_ln(nv,lpv,gen);
+          varsel.draw_tau2_ln(gen);
+          varsel.draw_lambda_lnLASSO(gen);
+        }
+        if(varsel.get_sparse()!=1) for(size_t j=0;j<p;j++) ivarprb[j]=::exp(lpv[j]);
+        bm.setpv(&ivarprb[0]);
+      }
+      DLAP(2);
+
+      if(type1sigest) {
+      //draw sigma
+	//rss is accumulated by bm.draw with the precisions 1/iw^2
+	sigma = sqrt((nu*lambda + bm.getrss())/gen.chi_square(df));
+	out.sigma(i-start, sigma);
+	bm.setwscale(1./(sigma*sigma));
+      }
+      DLAP(3);
+
+      if(type!=1) for(size_t k=0; k<n; k++) {
+	if(type==4) {
+	  //working response kappa/omega with kappa=y-1/2 and precision omega
+	  double omega=pgdraw.draw(1, Offset+bm.f(k), gen);
+	  wvec[k]=omega;
+	  z[k]=0.5*sign[k]/omega-Offset;
+	}
+	else {
+	  z[k]=sign[k]*rtnorm(sign[k]*bm.f(k), -sign[k]*Offset,
+			      (type==3) ? sqrt(lam[k]) : iw[k], gen);
+	  if(type==3) lmean[k]=sign[k]*bm.f(k);
+	  }
+      }
+
+      if(type==3) {
+	draw_lambda(n, &lam[0], &lmean[0], lprior, 1, gen);
+	for(size_t k=0; k<n; k++) wvec[k]=1./lam[k];
+      }
+      DLAP(1);
+
+      if(K>0) {
+	//only the trees in impute_tix change with the imputed columns
+	bm.gettrees(impute_vf, impute_tix);
+	size_t nmiss=impute_rows.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nmiss*K*impute_tix.size()>10000)
+#endif
+	for(size_t r=0; r<nmiss; ++r) {
+	  size_t k=impute_rows[r];
+	  double *xk=&ix[k*p];
+	  double sdk=1./sqrt(wvec[k]*bm.getwscale()), u;
+	  impute_base[r]=bm.f(k)-bm.predict(xk, impute_tix);
+	  for(size_t j=0; j<K; ++j) {
+	    for(size_t h=0; h<K; ++h) xk[impute_mult[h]]=0.;
+	    xk[impute_mult[j]]=1.;
+	    impute_fhat[r*K+j]=impute_base[r]+bm.predict(xk, impute_tix);
+	    u=(z[k]-impute_fhat[r*K+j])/sdk;
+	    impute_wt[r*K+j]=impute_prior_ptr[k+j*n]*::exp(-0.5*u*u)/(RTPI*sdk);
+	  }
+	}
+	//draws in row order: miss==2 rows copy the preceding imputed row
+	for(size_t k=0, r=0; k<n; ++k) {
+	  double *xk=&ix[k*p];
+	  if(impute_miss[k]==1) {
+	    for(size_t j=0; j<K; ++j) impute_post[j]=impute_wt[r*K+j];
+	    gen.set_wts(impute_post);
+	    size_t h=gen.discrete();
+	    for(size_t j=0; j<K; j++) {
+	      xk[impute_mult[j]]=0.;
+	      prevXV[impute_mult[j]]=0;
+	    }
+	    xk[impute_mult[h]]=1.;
+	    prevXV[impute_mult[h]]=1;
+	    bm.setf(k, impute_fhat[r*K+h]);
+	    ++r;
+	  }
+	  else if(impute_miss[k]==2) {
+	    double fbase=bm.f(k)-bm.predict(xk, impute_tix);
+	    for(size_t j=0; j<K; j++)
+	      xk[impute_mult[j]]=prevXV[impute_mult[j]];
+	    bm.setf(k, fbase+bm.predict(xk, impute_tix));
+	  }
+	}
+      }
+
+      DLAP(4);
+
+      if(i>=burn) {
+         if(nkeeptrain && (((i-burn+1) % skiptr) ==0)) {
+            for(size_t k=0;k<n;k++) {
+	      fhattrain[k]=Offset+bm.f(k);
+	      if(K>0) {
+		if(impute_miss[k]==1) {
+		  impute_draw1[k]=ix[k*p+impute_mult[0]];
+		  impute_draw2[k]=ix[k*p+impute_mult[1]];
+		} else {
+		  impute_draw1[k]=2;
+		  impute_draw2[k]=2;
+		}
+	      }
+	    }
+	    out.train(trcnt, &fhattrain[0]);
+	    if(K>0) out.impute(trcnt, &impute_draw1[0], &impute_draw2[0]);
+	    trcnt+=1;
+         }
+         keeptest = nkeeptest && (((i-burn+1) % skipte) ==0) && np;
+         tick=dclock::now();
+         if(keeptest) {
+	   if(testnodes) bm.predicttest(&fhattest[0]);
+	   else bm.predict(p,np,ixp,&fhattest[0]);
+           for(size_t k=0;k<np;k++) fhattest[k]+=Offset;
+	   out.test(tecnt, &fhattest[0]);
+           tecnt+=1;
+         }
+         DLAP(5);
+         keeptreedraw = nkeeptreedraws && (((i-burn+1) % skiptreedraws) ==0);
+         if(keeptreedraw) out.trees((i-burn)/skiptreedraws-cfg.nkept(start), bm);
+         DLAP(6);
+      }
+      if(diagevery && ((i+1)%diagevery)==0 && dgcnt<ndiag) {
+	for(size_t j=0; j<7; j++) {
+	  dg[j]=dtime[j];
+	  dtime[j]=0.;
+	}
+	dg[7]=ci.bprop;
+	dg[8]=ci.bacc;
+	dg[9]=ci.dprop;
+	dg[10]=ci.dacc;
+	ci.reset();
+	out.diag(dgcnt-cfg.ndiags(start), dg, bm);
+	dgcnt+=1;
+      }
+      if(cfg.checkevery && ((i+1)%cfg.checkevery)==0 && cfg.checkpoint.size()>0) {
+	//written aside and renamed so a checkpoint is never partial
+	std::string tmp=cfg.checkpoint+".tmp";
+	std::ofstream ck(tmp.c_str(), std::ios::binary);
+	std::vector<double> ximp(n*K);
+	for(size_t k=0; k<n; k++)
+	  for(size_t j=0; j<K; j++) ximp[k*K+j]=ix[k*p+impute_mult[j]];
+	ckput(ck, std::string(ckmagic));
+	ckput(ck, type);
+	ckput(ck, K);
+	ckput(ck, i+1);
+	ckput(ck, sigma);
+	ckput(ck, z);
+	ckput(ck, wvec);
+	ckput(ck, lam);
+	ckput(ck, prevXV);
+	ckput(ck, ximp);
+	ckput(ck, ivarprb);
+	ckput(ck, mvcnt);
+	varsel.save(ck);
+	bm.save(ck);
+	gen.save(ck);
+	ck.close();
+	if(!ck || std::rename(tmp.c_str(), cfg.checkpoint.c_str()))
+	  printf("*****Can't write checkpoint: %s\n", cfg.checkpoint.c_str());
+      }
+   }
+#undef DLAP
+   int time2 = time(&tp);
+   printf("time: %ds\n",time2-time1);
+   printf("trcnt,tecnt: %zu,%zu\n",trcnt,tecnt);
+   return true;
+}
+
+#endif
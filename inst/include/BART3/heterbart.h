@@ -25,14 +25,60 @@
 #include "bart.h"
 #include "heterbartfuns.h"
 #include "heterbd.h"
+#include "tshape.h"
 
 class heterbart : public bart
 {
   public:
-   heterbart():bart() { }
-   heterbart(size_t m):bart(m) { }
+   heterbart():bart(),w(0),wscale(1.),rss(0.),accept(0.),unitw(false),aug(false),np(0),xp(0),cover(false) { }
+   heterbart(size_t m):bart(m),w(0),wscale(1.),rss(0.),accept(0.),unitw(false),aug(false),np(0),xp(0),cover(false) { }
    void pr();
-   void draw(double *sigma, rn& gen, int shards=1);
+   //precision of y[i] is w[i]*wscale, w is not owned; unit: w is all
+   //ones and stays so, then the moves only count and sum (wunit, wscalar)
+   void setw(double *w, bool unit=false) {this->w=w; unitw=unit;}
+   void setwscale(double wscale) {this->wscale=wscale;}
+   double getwscale() {return wscale;}
+   //categorical strategy of births: data augment or degenerate trees
+   void setaug(bool aug) {this->aug=aug;}
+   //sum w[i]*(y[i]-f(i))^2 as of the end of the last draw
+   double getrss() {return rss;}
+   //move counts since the last reset
+   cinfo& getci() {return ci;}
+   //fraction of trees with an accepted move in the last draw
+   double getaccept() {return accept;}
+   //tree shapes as of the end of the last draw
+   tshape& getts() {return ts;}
+   //the nodes kept for the moves refer to the trees replaced here
+   void settree(std::string itv) {bart::settree(itv); tn.clear(); tb.clear(); tcn.clear(); tcb.clear(); ts.init(t);}
+   //test x (pxnp, not owned): the bottom node of each row in each tree
+   //follows the moves, so a prediction is a sum of mu's without traversals
+   void settest(size_t np, double *xp) {this->np=np; this->xp=xp; tb.clear();}
+   void predicttest(double *fp);
+   //keep the counts and the sums of w of the observations in the bottom
+   //nodes of each tree as of its last draw, for getcover
+   void setcover(bool cover) {this->cover=cover; if(!cover) {tcn.clear(); tcb.clear();}}
+   //tree j's counts and sums of w for each node in getnodes order
+   void getcover(size_t j, std::vector<double>& cn, std::vector<double>& cb);
+   void draw(rn& gen, int shards=1);
+   //checkpoints (ckpt.h): bart's state with the precision scale
+   void save(std::ostream& os);
+   bool load(std::istream& is);
+  protected:
+   double *w, wscale, rss, accept;
+   bool unitw, aug;
+   cinfo ci;
+   tshape ts;
+   std::vector<tnodes> tn; //the nodes of each tree for heterbd
+   scratch sc;
+   size_t np;
+   double *xp;
+   std::vector<tree::npv> tb; //bottom nodes of the test rows by tree
+   void settb(size_t j); //all test rows in tree j
+   void updtb(size_t j); //the test rows moved by the last move of tree j
+   template<class W> void drawt(rn& gen, int shards); //W: heterbartfuns.h
+   bool cover;
+   std::vector<std::vector<double> > tcn, tcb; //bottom nodes of each tree
+   void subcover(tree::tree_p x, size_t j, size_t& k, std::vector<double>& cn, std::vector<double>& cb);
 };
 
 //--------------------------------------------------
@@ -42,21 +88,148 @@ void heterbart::pr()
    bart::pr();
 }
 //--------------------------------------------------
-void heterbart::draw(double *sigma, rn& gen, int shards)
+//the weight policy is chosen once per draw
+void heterbart::draw(rn& gen, int shards)
 {
-   size_t i=0;
+   if(!unitw) drawt<wvector>(gen,shards);
+   else if(wscale==1. && shards==1) drawt<wunit>(gen,shards);
+   else drawt<wscalar>(gen,shards);
+}
+//--------------------------------------------------
+template<class W>
+void heterbart::drawt(rn& gen, int shards)
+{
+   size_t i=0, bacc, dacc;
+   if(ts.getm()!=m) ts.init(t);
+   if(tn.size()!=m) tn.resize(m);
+   if(aug || pi.pchange>0.) gen.set_cwts(pv); //for bprop and heterchange
+   if(np && tb.size()!=m) {
+      tb.resize(m);
+      for(size_t j=0;j<m;j++) settb(j);
+   }
    for(size_t j=0;j<m;j++) {
+      if(tn[j].gettop()!=&t[j]) { //new, or a copy's trees
+	 tn[j].init(t[j]);
+	 if(np) settb(j);
+      }
       fit(t[j],xi,p,n,x,ftemp);
       for(size_t k=0;k<n;k++) {
          allfit[k] = allfit[k]-ftemp[k];
          r[k] = y[k]-allfit[k];
       }
-      if(heterbd(t[j],xi,di,pi,sigma,nv,pv,false,gen,shards)) i++;
-      heterdrmu(t[j],xi,di,pi,sigma,gen);
+      bacc=ci.bacc; dacc=ci.dacc;
+      if(heterbd<W>(t[j],xi,di,pi,w,wscale,nv,pv,aug,gen,shards,&ci,&tn[j],&sc)) {
+	 i++;
+	 if(ci.bacc>bacc) ts.birth(j,ci.depth);
+	 else if(ci.dacc>dacc) ts.death(j,ci.depth);
+	 if(np) updtb(j);
+      }
+      heterdrmu<W>(t[j],xi,di,pi,w,wscale,gen,&sc);
+      if(cover) {
+	 if(tcn.size()!=m) {tcn.resize(m); tcb.resize(m);}
+	 tcn[j].assign(sc.n0.begin(),sc.n0.end());
+	 tcb[j].resize(sc.b0.size());
+	 for(size_t k=0;k<sc.b0.size();k++) tcb[j][k]=sc.b0[k]/wscale;
+      }
       fit(t[j],xi,p,n,x,ftemp);
-      for(size_t k=0;k<n;k++) allfit[k] += ftemp[k];
+      if(j<m-1) for(size_t k=0;k<n;k++) allfit[k] += ftemp[k];
+      else { //last tree: accumulate rss with the final residuals
+	 rss=0.;
+	 for(size_t k=0;k<n;k++) {
+	    allfit[k] += ftemp[k];
+	    double e = y[k]-allfit[k];
+	    rss += W::wt(w,k,1.)*e*e;
+	 }
+      }
+   }
+   accept=i/(double)m;
+}
+
+//--------------------------------------------------
+//the trees are summed in order for each row as in bart::predict
+void heterbart::predicttest(double *fp)
+{
+   if(tb.size()!=m) {
+      tb.resize(m);
+      for(size_t j=0;j<m;j++) settb(j);
+   }
+   for(size_t k=0;k<np;k++) fp[k]=0.0;
+   for(size_t j=0;j<m;j++) {
+      tree::npv& b=tb[j];
+      for(size_t k=0;k<np;k++) fp[k] += b[k]->gettheta();
    }
-   //   accept=i/(double)m;
+}
+//--------------------------------------------------
+void heterbart::getcover(size_t j, std::vector<double>& cn, std::vector<double>& cb)
+{
+   cn.clear(); cb.clear();
+   if(j>=tcn.size()) return;
+   size_t k=0;
+   subcover(&t[j],j,k,cn,cb);
+}
+//--------------------------------------------------
+//the nodes under x in getnodes order, k counts its bottom nodes
+void heterbart::subcover(tree::tree_p x, size_t j, size_t& k, std::vector<double>& cn, std::vector<double>& cb)
+{
+   size_t q=cn.size();
+   cn.push_back(0.); cb.push_back(0.);
+   if(x->getl()) {
+      subcover(x->getl(),j,k,cn,cb);
+      size_t r=cn.size();
+      subcover(x->getr(),j,k,cn,cb);
+      cn[q]=cn[q+1]+cn[r]; cb[q]=cb[q+1]+cb[r];
+   }
+   else {
+      cn[q]=tcn[j][k]; cb[q]=tcb[j][k];
+      k++;
+   }
+}
+//--------------------------------------------------
+void heterbart::settb(size_t j)
+{
+   tb[j].resize(np);
+   for(size_t k=0;k<np;k++) tb[j][k]=t[j].bn(xp+k*p,xi);
+}
+//--------------------------------------------------
+//only the rows in the bottom nodes of the move are found again: the
+//pointers to deleted nodes are compared, not followed
+void heterbart::updtb(size_t j)
+{
+   tnodes& x=tn[j];
+   tree::npv& b=tb[j];
+   if(x.mv=='b') {
+      for(size_t k=0;k<np;k++)
+	 if(b[k]==x.mx) b[k]=x.mx->bn(xp+k*p,xi);
+   }
+   else if(x.mv=='d') {
+      for(size_t k=0;k<np;k++)
+	 if(b[k]==x.ml || b[k]==x.mr) b[k]=x.mx;
+   }
+   else if(x.mv=='r') {
+      size_t d=x.mx->depth();
+      for(size_t k=0;k<np;k++) {
+	 tree::tree_p a=b[k];
+	 for(size_t h=a->depth();h>d;h--) a=a->getp();
+	 if(a==x.mx) b[k]=x.mx->bn(xp+k*p,xi);
+      }
+   }
+}
+//--------------------------------------------------
+void heterbart::save(std::ostream& os)
+{
+   bart::save(os);
+   ckput(os, wscale); ckput(os, rss); ckput(os, accept); ckput(os, ci);
+}
+//--------------------------------------------------
+bool heterbart::load(std::istream& is)
+{
+   if(!bart::load(is)) return false;
+   ckget(is, wscale); ckget(is, rss); ckget(is, accept); ckget(is, ci);
+   ts.init(t);
+   tn.clear();
+   tb.clear();
+   tcn.clear(); tcb.clear();
+   return (bool)is;
 }
 
 #endif
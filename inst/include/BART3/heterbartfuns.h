@@ -26,24 +26,62 @@
 #include "treefuns.h"
 #include "info.h"
 
+//--------------------------------------------------
+//the scratch vectors of a chain, reused by the moves and the draws of the
+//bottom node mu's: they are cleared, not freed, so once they have grown
+//an iteration only allocates the nodes of new trees
+struct scratch {
+   tree::npv bnv, nds;
+   std::vector<size_t> idx, n0, n1;
+   std::vector<double> b0, M0, b1, M1;
+};
+//--------------------------------------------------
+//weight policies: the precision of y[i] is wt(w,i,ws) times ws if post,
+//with ws=wscale/shards; the policy is a template argument of the kernels
+//so that without weights they only count and sum
+struct wvector { //per-observation w
+   static double wt(const double *w, size_t i, double ws) {return w[i]*ws;}
+   static const bool post=false;
+};
+struct wscalar { //w all ones: b and M are scaled once
+   static double wt(const double*, size_t, double) {return 1.;}
+   static const bool post=true;
+};
+struct wunit { //w all ones and ws one
+   static double wt(const double*, size_t, double) {return 1.;}
+   static const bool post=false;
+};
 //--------------------------------------------------
 //heterlh, replacement for lil that only depends on sum y.
 double heterlh(double b, double M, double tau);
 //--------------------------------------------------
 //compute b and M  for left and right give bot and v,c
-void hetergetsuff(tree& x, tree::tree_p nx, size_t v, size_t c, xinfo& xi, dinfo& di, size_t& nl, double& bl, double& Ml, size_t& nr, double& br, double& Mr, double *sigma, int shards=1);
+template<class W=wvector>
+void hetergetsuff(tree& x, tree::tree_p nx, size_t v, size_t c, xinfo& xi, dinfo& di, size_t& nl, double& bl, double& Ml, size_t& nr, double& br, double& Mr, double *w, double wscale=1., int shards=1);
 //--------------------------------------------------
 //compute b and M for left and right bots
-void hetergetsuff(tree& x, tree::tree_p l, tree::tree_p r, xinfo& xi, dinfo& di, double& bl, double& Ml, double& br, double& Mr, double *sigma, int shards=1);
+template<class W=wvector>
+void hetergetsuff(tree& x, tree::tree_p l, tree::tree_p r, xinfo& xi, dinfo& di, double& bl, double& Ml, double& br, double& Mr, double *w, double wscale=1., int shards=1);
+//--------------------------------------------------
+//compute n, b and M for the bottom nodes under top, idx gets the observations there
+template<class W=wvector>
+void hetersubsuff(tree& x, tree::tree_p top, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<size_t>& nv, std::vector<double>& bv, std::vector<double>& Mv, std::vector<size_t>& idx, double *w, double wscale=1., int shards=1);
+//--------------------------------------------------
+//compute n, b and M for the bottom nodes under top from the observations idx
+template<class W=wvector>
+void hetersubsuff(tree::tree_p top, xinfo& xi, dinfo& di, std::vector<size_t>& idx, tree::npv& bnv, std::vector<size_t>& nv, std::vector<double>& bv, std::vector<double>& Mv, double *w, double wscale=1., int shards=1);
 //--------------------------------------------------
 //draw one mu from post
 double heterdrawnodemu(double b, double M, double tau, rn& gen);
 //--------------------------------------------------
 //get sufficients stats for all bottom nodes, this way just loop through all the data once.
-void heterallsuff(tree& x, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<double>& bv, std::vector<double>& Mv, double *sigma);
+//nv, if not 0, gets the number of observations in each
+template<class W=wvector>
+void heterallsuff(tree& x, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<double>& bv, std::vector<double>& Mv, double *w, double wscale=1., std::vector<size_t>* nv=0);
 //--------------------------------------------------
 //heter version of drmu, need b and M instead of n and sy
-void heterdrmu(tree& t, xinfo& xi, dinfo& di, pinfo& pi, double *sigma, rn& gen);
+template<class W=wvector>
+void heterdrmu(tree& t, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale, rn& gen, scratch* sc=0);
 
 //--------------------------------------------------
 //heterlh, replacement for lil that only depends on sum y.
@@ -54,54 +92,93 @@ double heterlh(double b, double M, double tau) {
 }
 //--------------------------------------------------
 //compute b and M  for left and right give bot and v,c
-void hetergetsuff(tree& x, tree::tree_p nx, size_t v, size_t c, xinfo& xi, dinfo& di, size_t& nl, double& bl, double& Ml, size_t& nr,  double& br, double& Mr, double *sigma, int shards)
+template<class W>
+void hetergetsuff(tree& x, tree::tree_p nx, size_t v, size_t c, xinfo& xi, dinfo& di, size_t& nl, double& bl, double& Ml, size_t& nr,  double& br, double& Mr, double *w, double wscale, int shards)
 {
    double *xx;//current x
    bl=0; Ml=0.0; br=0; Mr=0.0; nl=0; nr=0;
-   double w;
+   double wi, ws=wscale/shards;
 
    for(size_t i=0;i<di.n;i++) {
       xx = di.x + i*di.p;
       if(nx==x.bn(xx,xi)) { //does the bottom node = xx's bottom node
-         w=pow(sigma[i], -2.)/shards;
-         //w= 1.0/(sigma[i]*sigma[i]);
+         wi=W::wt(w,i,ws);
          if(xx[v] < xi[v][c]) {
                nl+=1;
-               bl+=w;
-               Ml += w*di.y[i];
+               bl+=wi;
+               Ml += wi*di.y[i];
           } else {
                nr+=1;
-               br+=w;;
-               Mr += w*di.y[i];
+               br+=wi;
+               Mr += wi*di.y[i];
           }
       }
    }
+   if(W::post) {bl*=ws; Ml*=ws; br*=ws; Mr*=ws;}
 }
 //--------------------------------------------------
 //compute b and M for left and right bots
-void hetergetsuff(tree& x, tree::tree_p l, tree::tree_p r, xinfo& xi, dinfo& di, double& bl, double& Ml, double& br, double& Mr, double *sigma, int shards)
+template<class W>
+void hetergetsuff(tree& x, tree::tree_p l, tree::tree_p r, xinfo& xi, dinfo& di, double& bl, double& Ml, double& br, double& Mr, double *w, double wscale, int shards)
 {
 
    double *xx;//current x
    bl=0; Ml=0.0; br=0; Mr=0.0;
-   double w;
+   double wi, ws=wscale/shards;
 
    for(size_t i=0;i<di.n;i++) {
       xx = di.x + i*di.p;
       tree::tree_cp bn = x.bn(xx,xi);
       if(bn==l) {
-	w=pow(sigma[i], -2.)/shards;
-         //w = 1.0/(sigma[i]*sigma[i]);
-         bl+=w;
-         Ml += w*di.y[i];
+         wi=W::wt(w,i,ws);
+         bl+=wi;
+         Ml += wi*di.y[i];
       }
       if(bn==r) {
-	w=pow(sigma[i], -2.)/shards;
-         //w = 1.0/(sigma[i]*sigma[i]);
-         br+=w;
-         Mr += w*di.y[i];
+         wi=W::wt(w,i,ws);
+         br+=wi;
+         Mr += wi*di.y[i];
       }
    }
+   if(W::post) {bl*=ws; Ml*=ws; br*=ws; Mr*=ws;}
+}
+//--------------------------------------------------
+//compute n, b and M for the bottom nodes under top, idx gets the observations there
+template<class W>
+void hetersubsuff(tree& x, tree::tree_p top, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<size_t>& nv, std::vector<double>& bv, std::vector<double>& Mv, std::vector<size_t>& idx, double *w, double wscale, int shards)
+{
+   size_t d=top->depth();
+   idx.clear();
+   for(size_t i=0;i<di.n;i++) {
+      tree::tree_p bn = x.bn(di.x + i*di.p,xi);
+      size_t dbn = bn->depth();
+      if(dbn<d) continue;
+      for(;dbn>d;dbn--) bn=bn->getp(); //ancestor at the depth of top
+      if(bn==top) idx.push_back(i);
+   }
+   hetersubsuff<W>(top,xi,di,idx,bnv,nv,bv,Mv,w,wscale,shards);
+}
+//--------------------------------------------------
+//compute n, b and M for the bottom nodes under top from the observations idx
+template<class W>
+void hetersubsuff(tree::tree_p top, xinfo& xi, dinfo& di, std::vector<size_t>& idx, tree::npv& bnv, std::vector<size_t>& nv, std::vector<double>& bv, std::vector<double>& Mv, double *w, double wscale, int shards)
+{
+   bnv.clear();
+   top->getbots(bnv);
+   size_t nb=bnv.size(), ni;
+   nv.assign(nb,0); bv.assign(nb,0.); Mv.assign(nb,0.);
+   double wi, ws=wscale/shards;
+
+   for(size_t h=0;h<idx.size();h++) {
+      size_t i=idx[h];
+      tree::tree_p bn = top->bn(di.x + i*di.p,xi);
+      for(ni=0;bnv[ni]!=bn;ni++); //few bottom nodes
+      wi=W::wt(w,i,ws);
+      nv[ni]++;
+      bv[ni]+=wi;
+      Mv[ni]+=wi*di.y[i];
+   }
+   if(W::post) for(ni=0;ni<nb;ni++) {bv[ni]*=ws; Mv[ni]*=ws;}
 }
 //--------------------------------------------------
 //draw one mu from post
@@ -113,7 +190,8 @@ double heterdrawnodemu(double b, double M, double tau, rn& gen)
 }
 //--------------------------------------------------
 //get sufficients stats for all bottom nodes, this way just loop through all the data once.
-void heterallsuff(tree& x, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<double>& bv, std::vector<double>& Mv,double *sigma)
+template<class W>
+void heterallsuff(tree& x, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<double>& bv, std::vector<double>& Mv, double *w, double wscale, std::vector<size_t>* nv)
 {
    tree::tree_cp tbn; //the pointer to the bottom node for the current observations
    size_t ni;         //the  index into vector of the current bottom node
@@ -124,32 +202,34 @@ void heterallsuff(tree& x, xinfo& xi, dinfo& di, tree::npv& bnv, std::vector<dou
 
    typedef tree::npv::size_type bvsz;
    bvsz nb = bnv.size();
-   bv.resize(nb);
-   Mv.resize(nb);
-
-   std::map<tree::tree_cp,size_t> bnmap;
-   for(bvsz i=0;i!=bnv.size();i++) {bnmap[bnv[i]]=i;bv[i]=0;Mv[i]=0.0;}
+   bv.assign(nb,0.);
+   Mv.assign(nb,0.);
+   if(nv) nv->assign(nb,0);
 
-   double w;
+   double wi;
    for(size_t i=0;i<di.n;i++) {
-     w=pow(sigma[i], -2.);
-     // w = 1.0/(sigma[i]*sigma[i]);
+      wi=W::wt(w,i,wscale);
       xx = di.x + i*di.p;
       tbn = x.bn(xx,xi);
-      ni = bnmap[tbn];
+      for(ni=0;bnv[ni]!=tbn;ni++); //few bottom nodes
 
-      bv[ni] += w;
-      Mv[ni] += w*di.y[i];
+      bv[ni] += wi;
+      Mv[ni] += wi*di.y[i];
+      if(nv) (*nv)[ni]++;
    }
+   if(W::post) for(ni=0;ni<nb;ni++) {bv[ni]*=wscale; Mv[ni]*=wscale;}
 }
 //--------------------------------------------------
 //heter version of drmu, need b and M instead of n and sy
-void heterdrmu(tree& t, xinfo& xi, dinfo& di, pinfo& pi, double *sigma, rn& gen)
+template<class W>
+void heterdrmu(tree& t, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale, rn& gen, scratch* sc)
 {
-   tree::npv bnv;
-   std::vector<double> bv;
-   std::vector<double> Mv;
-   heterallsuff(t,xi,di,bnv,bv,Mv,sigma);
+   scratch sx;
+   if(!sc) sc = &sx;
+   tree::npv& bnv = sc->bnv;
+   std::vector<double>& bv = sc->b0;
+   std::vector<double>& Mv = sc->M0;
+   heterallsuff<W>(t,xi,di,bnv,bv,Mv,w,wscale,&sc->n0);
    for(tree::npv::size_type i=0;i!=bnv.size();i++)
       bnv[i]->settheta(heterdrawnodemu(bv[i],Mv[i],pi.tau,gen));
 }
@@ -27,15 +27,52 @@
 #include "treefuns.h"
 #include "bartfuns.h"
 #include "heterbartfuns.h"
+#include "tnodes.h"
 
-bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *sigma, 
-	     std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, int shards=1);
+//with aug or pi.pchange>0, gen.set_cwts(pv) is up to the caller once per
+//sweep as in heterbart::drawt
+template<class W=wvector>
+bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale,
+	     std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, int shards=1, cinfo* ci=0, tnodes* tn=0, scratch* sc=0);
 
-bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *sigma, 
-	     std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, int shards)
+//change: redraw the rule of a nog node
+template<class W=wvector>
+bool heterchange(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale,
+		 std::vector<size_t>& nv, std::vector<double>& pv, rn& gen, int shards=1, cinfo* ci=0, tnodes* tn=0, scratch* sc=0);
+//swap: exchange the rules of a node and its parent
+template<class W=wvector>
+bool heterswap(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale,
+	       std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, int shards=1, cinfo* ci=0, tnodes* tn=0, scratch* sc=0);
+
+template<class W>
+bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale,
+	     std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, int shards, cinfo* ci, tnodes* tn, scratch* sc)
 {
-   tree::npv goodbots;  //nodes we could birth at (split on)
-   double PBx = getpb(x,xi,pi,goodbots); //prob of a birth at x
+   //the nodes of x are kept in tn across calls, else found here
+   tnodes tx;
+   if(!tn) {
+      tx.init(x);
+      tn = &tx;
+   }
+
+   //a tree with a nog changes or swaps with prob 1-pbd, else birth/death
+   double Pbdx = 1.0; //prob of a birth/death move at x
+   if(pi.pbd<1.0 && tn->bots.size()>1) {
+      Pbdx = pi.pbd;
+      double u = gen.uniform();
+      if(u >= pi.pbd) {
+         if(u < pi.pbd+pi.pchange)
+            return heterchange<W>(x,xi,di,pi,w,wscale,nv,pv,gen,shards,ci,tn,sc);
+         else return heterswap<W>(x,xi,di,pi,w,wscale,nv,pv,aug,gen,shards,ci,tn,sc);
+      }
+   }
+
+   tn->update(xi);
+   tree::npv& goodbots = tn->goodbots;  //nodes we could birth at (split on)
+   double PBx; //prob of a birth at x, as getpb
+   if(goodbots.size()==0) PBx = 0.0;
+   else if(tn->bots.size()==1) PBx = 1.0;
+   else PBx = pi.pb;
 
    if(gen.uniform() < PBx) { //do birth or death
 
@@ -44,14 +81,16 @@ bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *sigma,
       tree::tree_p nx; //bottom node
       size_t v,c; //variable and cutpoint
       double pr; //part of metropolis ratio from proposal and prior
-      bprop(x,xi,pi,goodbots,PBx,nx,v,c,pr,nv,pv,aug,gen);
+      bprop(x,xi,pi,goodbots,PBx,nx,v,c,pr,nv,pv,aug,gen,&tn->nogs);
+      if(pi.pbd<1.0) pr *= pi.pbd/Pbdx; //y has a nog
+      if(ci) ci->bprop++;
 
       //--------------------------------------------------
       //compute sufficient statistics
       size_t nr,nl; //counts in proposed bots
       double bl,br; //sums of weights
       double Ml, Mr; //weighted sum of y in proposed bots
-      hetergetsuff(x,nx,v,c,xi,di,nl,bl,Ml,nr,br,Mr,sigma,shards);
+      hetergetsuff<W>(x,nx,v,c,xi,di,nl,bl,Ml,nr,br,Mr,w,wscale,shards);
 
       //--------------------------------------------------
       //compute alpha
@@ -76,7 +115,9 @@ bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *sigma,
          mul = heterdrawnodemu(bl,Ml,pi.tau,gen);
          mur = heterdrawnodemu(br,Mr,pi.tau,gen);
          x.birthp(nx,v,c,mul,mur);
+         tn->birth(nx);
 	 nv[v]++;
+	 if(ci) {ci->bacc++; ci->depth=nx->depth();}
          return true;
       } else {
          return false;
@@ -86,13 +127,15 @@ bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *sigma,
       //draw proposal
       double pr;  //part of metropolis ratio from proposal and prior
       tree::tree_p nx; //nog node to death at
-      dprop(x,xi,pi,goodbots,PBx,nx,pr,gen);
+      dprop(x,xi,pi,goodbots,PBx,nx,pr,gen,&tn->nogs);
+      if(pi.pbd<1.0) pr *= (tn->bots.size()>2 ? pi.pbd : 1.0)/Pbdx; //y may be the top alone
+      if(ci) ci->dprop++;
 
       //--------------------------------------------------
       //compute sufficient statistics
       double br,bl; //sums of weights
       double Ml, Mr; //weighted sums of y
-      hetergetsuff(x, nx->getl(), nx->getr(), xi, di, bl, Ml, br, Mr, sigma, shards);
+      hetergetsuff<W>(x, nx->getl(), nx->getr(), xi, di, bl, Ml, br, Mr, w, wscale, shards);
 
       //--------------------------------------------------
       //compute alpha
@@ -111,12 +154,150 @@ bool heterbd(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *sigma,
       if(log(gen.uniform()) < lalpha) {
          mu = heterdrawnodemu(bl+br,Ml+Mr,pi.tau,gen);
 	 nv[nx->getv()]--;
+         tn->death(nx);
          x.deathp(nx,mu);
+	 if(ci) {ci->dacc++; ci->depth=nx->depth();}
          return true;
       } else {
          return false;
       }
    }
 }
+//--------------------------------------------------
+//change: the variable is drawn from pv and the cutpoint uniformly from its
+//range at the nog node as in bprop, so the proposal and the prior of the
+//rule cancel; the shape and the nog nodes are unchanged
+template<class W>
+bool heterchange(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale,
+		 std::vector<size_t>& nv, std::vector<double>& pv, rn& gen, int shards, cinfo* ci, tnodes* tn, scratch* sc)
+{
+   tree::npv nognds; //nog nodes
+   if(tn) tn->update(xi);
+   else x.getnogs(nognds);
+   tree::npv& nogs = tn ? tn->nogs : nognds;
+   tree::tree_p nx = nogs[floor(gen.uniform()*nogs.size())];
+   if(ci) ci->cprop++;
+
+   //--------------------------------------------------
+   //draw proposal
+   size_t v0=nx->getv(), c0=nx->getc(), v, c;
+   int L,U;
+   std::vector<size_t> none; //v from all of pv, as set_cwts once per sweep
+   v = gen.cdiscrete(none,gen.get_cwts_sum());
+   L=0; U=xi[v].size()-1;
+   nx->rg(v,&L,&U);
+   if(U<L) return false; //v is exhausted at nx
+   c = L + floor(gen.uniform()*(U-L+1));
+   if(v==v0 && c==c0) return false;
+
+   //--------------------------------------------------
+   //compute sufficient statistics and prior of the children, now and with v,c
+   scratch sx;
+   if(!sc) sc = &sx;
+   tree::npv& bnv = sc->bnv;
+   std::vector<size_t> &idx = sc->idx, &n0 = sc->n0, &n1 = sc->n1;
+   std::vector<double> &b0 = sc->b0, &M0 = sc->M0, &b1 = sc->b1, &M1 = sc->M1;
+   hetersubsuff<W>(x,nx,xi,di,bnv,n0,b0,M0,idx,w,wscale,shards);
+   double PG0 = (1.0-pgrow(nx->getl(),xi,pi))*(1.0-pgrow(nx->getr(),xi,pi));
+   nx->setv(v); nx->setc(c);
+   hetersubsuff<W>(nx,xi,di,idx,bnv,n1,b1,M1,w,wscale,shards);
+   double PG1 = (1.0-pgrow(nx->getl(),xi,pi))*(1.0-pgrow(nx->getr(),xi,pi));
+
+   //--------------------------------------------------
+   //compute alpha: the children must have 5 observations as for a birth
+   double lalpha = -INFINITY;
+   if(n0[0]>=5 && n0[1]>=5 && n1[0]>=5 && n1[1]>=5) {
+      lalpha = log(PG1/PG0) + heterlh(b1[0],M1[0],pi.tau) + heterlh(b1[1],M1[1],pi.tau)
+         - heterlh(b0[0],M0[0],pi.tau) - heterlh(b0[1],M0[1],pi.tau);
+      lalpha = std::min(0.0,lalpha);
+   }
+
+   //--------------------------------------------------
+   //try metrop: the bottom node mu's are drawn afterwards
+   if(log(gen.uniform()) < lalpha) {
+      nv[v0]--;
+      nv[v]++;
+      if(tn) tn->setstale(nx);
+      if(ci) ci->cacc++;
+      return true;
+   } else {
+      nx->setv(v0); nx->setc(c0);
+      return false;
+   }
+}
+//--------------------------------------------------
+//swap: an interior node other than the top is drawn uniformly and its
+//rule exchanged with its parent's, with both children's if they have the
+//same rule; the shape is unchanged so the proposal is symmetric, but with
+//aug the rule prior is normalized per node over its good variables
+template<class W>
+bool heterswap(tree& x, xinfo& xi, dinfo& di, pinfo& pi, double *w, double wscale,
+	       std::vector<size_t>& nv, std::vector<double>& pv, bool aug, rn& gen, int shards, cinfo* ci, tnodes* tn, scratch* sc)
+{
+   scratch sx;
+   if(!sc) sc = &sx;
+   tree::npv& ints = sc->nds; //interior nodes other than the top
+   ints.clear();
+   x.getnodes(ints);
+   size_t k=0;
+   for(size_t i=0;i<ints.size();i++)
+      if(ints[i]->getl() && ints[i]->getp()) ints[k++]=ints[i];
+   ints.resize(k);
+   if(ints.size()==0) return false; //a nog at the top
+   tree::tree_p nx = ints[floor(gen.uniform()*ints.size())];
+   if(ci) ci->sprop++;
+
+   //--------------------------------------------------
+   //draw proposal
+   tree::tree_p np = nx->getp(), ns = (nx==np->getl()) ? np->getr() : np->getl();
+   size_t vp=np->getv(), cp=np->getc(), vx=nx->getv(), cx=nx->getc();
+   if(vp==vx && cp==cx) return false;
+   bool both = ns->getl() && ns->getv()==vx && ns->getc()==cx;
+
+   //--------------------------------------------------
+   //compute sufficient statistics and prior under np, now and swapped
+   tree::npv& bnv = sc->bnv;
+   std::vector<size_t> &idx = sc->idx, &n0 = sc->n0, &n1 = sc->n1;
+   std::vector<double> &b0 = sc->b0, &M0 = sc->M0, &b1 = sc->b1, &M1 = sc->M1;
+   hetersubsuff<W>(x,np,xi,di,bnv,n0,b0,M0,idx,w,wscale,shards);
+   double spv = aug ? gen.get_cwts_sum() : 0.; //cwts are set for pv with aug
+   double lp0 = lsubprior(np,xi,pi,pv,spv);
+   np->setv(vx); np->setc(cx);
+   nx->setv(vp); nx->setc(cp);
+   if(both) {ns->setv(vp); ns->setc(cp);}
+   double lp1 = lsubprior(np,xi,pi,pv,spv);
+
+   //--------------------------------------------------
+   //compute alpha: the swapped rules must be within range and the bottom
+   //nodes must have 5 observations
+   double lalpha = -INFINITY;
+   if(lp1 > -INFINITY) {
+      hetersubsuff<W>(np,xi,di,idx,bnv,n1,b1,M1,w,wscale,shards);
+      bool ok = true;
+      lalpha = lp1-lp0;
+      for(size_t i=0;i<bnv.size();i++) {
+         ok = ok && n0[i]>=5 && n1[i]>=5;
+         lalpha += heterlh(b1[i],M1[i],pi.tau)-heterlh(b0[i],M0[i],pi.tau);
+      }
+      lalpha = ok ? std::min(0.0,lalpha) : -INFINITY;
+   }
+
+   //--------------------------------------------------
+   //try metrop: the bottom node mu's are drawn afterwards
+   if(log(gen.uniform()) < lalpha) {
+      if(both) { //vx loses a rule to vp
+         nv[vx]--;
+         nv[vp]++;
+      }
+      if(tn) tn->setstale(np);
+      if(ci) ci->sacc++;
+      return true;
+   } else {
+      np->setv(vp); np->setc(cp);
+      nx->setv(vx); nx->setc(cx);
+      if(both) {ns->setv(vx); ns->setc(cx);}
+      return false;
+   }
+}
 
 #endif
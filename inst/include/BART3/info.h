@@ -38,19 +38,38 @@ public:
 class pinfo
 {
 public:
-   pinfo(): pbd(1.0),pb(.5),alpha(.95),mybeta(2.0),tau(1.0) {}
+   pinfo(): pbd(1.0),pb(.5),pchange(0.),alpha(.95),mybeta(2.0),tau(1.0) {setpg();}
 //mcmc info
    double pbd; //prob of birth/death
    double pb;  //prob of birth
+   double pchange; //prob of change, swap is 1-pbd-pchange
 //prior info
    double alpha;
    double mybeta;
    double tau;
+   //prior prob a node at depth d grows (if it can split), alpha/(1+d)^mybeta,
+   //from a table: setpg again whenever alpha or mybeta is set
+   enum {pgdepth=64};
+   double pgt[pgdepth];
+   void setpg() {for(size_t d=0;d<pgdepth;d++) pgt[d]=alpha/pow(1.0+d,mybeta);}
+   double pg(size_t d) {return d<pgdepth ? pgt[d] : alpha/pow(1.0+d,mybeta);}
    void pr() {
-      cout << "pbd,pb: " << pbd << ", " << pb << std::endl;
+      cout << "pbd,pb,pchange: " << pbd << ", " << pb << ", " << pchange << std::endl;
       cout << "alpha,beta,tau: " << alpha << 
              ", " << mybeta << ", " << tau << std::endl;
    }
 };
+//proposal and acceptance counts
+class cinfo
+{
+public:
+   cinfo() {reset();}
+   size_t bprop, bacc; //births proposed, accepted
+   size_t dprop, dacc; //deaths proposed, accepted
+   size_t cprop, cacc; //changes proposed, accepted
+   size_t sprop, sacc; //swaps proposed, accepted
+   size_t depth; //depth of the node of the last accepted birth/death
+   void reset() {bprop=0;bacc=0;dprop=0;dacc=0;cprop=0;cacc=0;sprop=0;sacc=0;depth=0;}
+};
 
 #endif
@@ -29,18 +29,44 @@ using ::pnorm;
 #else
 using R::pnorm;
 RcppExport SEXP cdraw_lambda_i(SEXP lambda, SEXP mean, SEXP kmax, SEXP thin);
+RcppExport SEXP cdraw_lambda(SEXP lambda, SEXP mean, SEXP kmax, SEXP thin);
 #endif
 
+/* number of mixture terms drawn exactly: the remaining terms   *
+ * up to kmax are replaced by a moment-matched gamma; the tail   *
+ * has mean 2/(1+kexact) and variance < 4/(3*kexact^3) so the    *
+ * error is on the order of the neglected third cumulant         */
+#define LAMBDA_KEXACT 20
+
+/* precomputed mixture weights for the lambda prior */
+class lambdaprior {
+public:
+  lambdaprior(int kmax=1000, int kexact=LAMBDA_KEXACT);
+  double draw(rn& gen);
+  int getkmax() {return kmax;}
+private:
+  int kmax, kexact;
+  std::vector<double> psii; //psii[k]=2/(1+k)^2 for k<kexact
+  double tshape, trate;     //gamma for sum_{k=kexact}^{kmax} psii[k]*E_k
+};
+
 /* draw lambda from its (infinite mixture) prior */
 
-double draw_lambda_prior(double *psii, int kmax, rn& gen);
+double draw_lambda_prior(lambdaprior& lp, rn& gen);
 
 /* Metropolis-Hastings algorithm for drawing lambda from its *
  * full conditional -- uses proposals from the prior         */
 
+double draw_lambda_i(double lambda_old, double xbeta,
+                     lambdaprior& lp, int thin, rn& gen);
 double draw_lambda_i(double lambda_old, double xbeta,
                      int kmax, int thin, rn& gen);
 
+/* update the whole vector lambda[0], ..., lambda[n-1] in place */
+
+void draw_lambda(size_t n, double *lambda, double *xbeta,
+                 lambdaprior& lp, int thin, rn& gen);
+
 #ifndef NoRcpp
 
 RcppExport SEXP cdraw_lambda_i(SEXP lambda, SEXP mean, SEXP kmax, SEXP thin) {
@@ -51,67 +77,105 @@ RcppExport SEXP cdraw_lambda_i(SEXP lambda, SEXP mean, SEXP kmax, SEXP thin) {
 				  Rcpp::as<int>(thin), gen));
 }
 
+RcppExport SEXP cdraw_lambda(SEXP lambda, SEXP mean, SEXP kmax, SEXP thin) {
+  arn gen;
+  lambdaprior lp(Rcpp::as<int>(kmax));
+  Rcpp::NumericVector l=Rcpp::clone(Rcpp::NumericVector(lambda)), m(mean);
+  size_t n=l.size(), M=m.size();
+  if(M==n) draw_lambda(n, &l[0], &m[0], lp, Rcpp::as<int>(thin), gen);
+  else for(size_t i=0; i<n; ++i)
+    l[i]=draw_lambda_i(l[i], m[i%M], lp, Rcpp::as<int>(thin), gen);
+  return Rcpp::wrap(l);
+}
+
 #endif
 
+lambdaprior::lambdaprior(int kmax, int kexact):kmax(kmax),tshape(0.),trate(0.)
+{
+  if(kexact>kmax+1) kexact=kmax+1;
+  this->kexact=kexact;
+
+  psii.resize(kexact);
+  for(int k=0; k<kexact; k++) psii[k] = 2.0/((1.0+k)*(1.0+k));
+
+  double m=0., v=0., w;
+  for(int k=kmax; k>=kexact; k--) { // smallest first for accuracy
+    w = 2.0/((1.0+k)*(1.0+k));
+    m += w;
+    v += w*w;
+  }
+  if(v>0.) {
+    tshape = m*m/v;
+    trate = m/v;
+  }
+}
+
 /* draw lambda from its (infinite mixture) prior */
 
-double draw_lambda_prior(double *psii, int kmax, rn& gen)
+double lambdaprior::draw(rn& gen)
 {
-  double lambda;
-  int k;
+  double lambda = 0.0;
 
-  lambda = 0.0;
-  for(k=0; k<=kmax; k++) {
+  for(int k=0; k<kexact; k++) {
     lambda += psii[k] * gen.exp(); 
     //lambda += psii[k] * expo_rand(state);
   }
+  if(tshape>0.) lambda += gen.gamma(tshape, trate);
 
   return lambda;
 }
 
+double draw_lambda_prior(lambdaprior& lp, rn& gen)
+{
+  return lp.draw(gen);
+}
 
 /* Metropolis-Hastings algorithm for drawing lambda from its *
  * full conditional -- uses proposals from the prior         */
 
 double draw_lambda_i(double lambda_old, double xbeta,
-                     int kmax, int thin, rn& gen)
+                     lambdaprior& lp, int thin, rn& gen)
 {
-  int t, k;
-  double lambda, lp, lpold, m, s;
-  double *psii;
+  int t;
+  double lambda, lp_new, lpold;
 
   /* calculate the probability og the previous lambda */
-  s = sqrt(lambda_old);
-  m = xbeta;
-  lpold = pnorm(0.0, m, s, 0, 1);
-
-  /* allocate psii */
-  psii = (double*) malloc(sizeof(double) * (kmax+1));
-  for(k=0; k<=kmax; k++) psii[k] =  2.0/((1.0+k)*(1.0+k));
+  lpold = pnorm(0.0, xbeta, sqrt(lambda_old), 0, 1);
 
   /* thinning is essential when kappa is large */
   for(t=0; t<thin; t++) {
 
     /* propose a new lambda from the prior */
-    lambda = draw_lambda_prior(psii, kmax, gen);
+    lambda = lp.draw(gen);
 
     /* calculate the probability of the propsed lambda */
-    s = sqrt(lambda);
-    m = xbeta;
-    lp = pnorm(0.0, m, s, 0, 1);
+    lp_new = pnorm(0.0, xbeta, sqrt(lambda), 0, 1);
 
     /* MH accept or reject */
     //if(runi(state) < exp(lp - lpold)) {
-    if(gen.uniform() < exp(lp - lpold)) {
+    if(gen.uniform() < exp(lp_new - lpold)) {
       lambda_old = lambda;
-      lpold = lp;
+      lpold = lp_new;
     }
   }
 
-  /* possibly clean up psii */
-  free(psii);
-
   return lambda_old;
 }
 
+double draw_lambda_i(double lambda_old, double xbeta,
+                     int kmax, int thin, rn& gen)
+{
+  lambdaprior lp(kmax);
+  return draw_lambda_i(lambda_old, xbeta, lp, thin, gen);
+}
+
+/* update the whole vector lambda[0], ..., lambda[n-1] in place */
+
+void draw_lambda(size_t n, double *lambda, double *xbeta,
+                 lambdaprior& lp, int thin, rn& gen)
+{
+  for(size_t i=0; i<n; i++)
+    lambda[i] = draw_lambda_i(lambda[i], xbeta[i], lp, thin, gen);
+}
+
 #endif
@@ -26,12 +26,21 @@
 #ifndef POLYAGAMMA_HYBRID
 #define POLYAGAMMA_HYBRID
 
+extern void rpg_hybrid(double& x, double h, double z, rn& gen,
+		       PolyaGamma& dv, PolyaGammaApproxSP& sp);
+
 extern void rpg_hybrid(double& x, double h, double z, rn& gen)
 {
     PolyaGamma dv(1000);
     // PolyaGammaApproxAlt alt;
     PolyaGammaApproxSP sp;
+    rpg_hybrid(x, h, z, gen, dv, sp);
+}
 
+// with the samplers of the caller: dv(1000) is built once
+extern void rpg_hybrid(double& x, double h, double z, rn& gen,
+		       PolyaGamma& dv, PolyaGammaApproxSP& sp)
+{
 #ifdef USE_R
     GetRNGstate();
 #endif
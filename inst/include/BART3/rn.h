@@ -40,7 +40,36 @@ class rn
   virtual size_t geometric(double p) = 0; //geometric distribution
   virtual void set_wts(std::vector<double>& _wts) = 0;
   virtual std::vector<double> log_dirichlet(std::vector<double>& alpha) = 0; 
+  //state for checkpoints (ckpt.h): a no-op unless overridden
+  virtual void save(std::ostream& os) {}
+  virtual void load(std::istream& is) {}
   virtual ~rn() {}
+  //draws from weights set once, but excluding some categories each time
+  void set_cwts(std::vector<double>& _wts) {
+    double smw=0.;
+    cwts.resize(_wts.size());
+    for(size_t j=0;j<_wts.size();j++) cwts[j] = (smw+=_wts[j]);
+  }
+  double get_cwts_sum() {return cwts.size() ? cwts.back() : 0.;}
+  size_t get_cwts_size() {return cwts.size();}
+  //categories not in ex (sorted) with weight sum sm: the target moves up
+  //past each excluded weight below it, so a draw is O(|ex| log p)
+  size_t cdiscrete(std::vector<size_t>& ex, double sm) {
+    size_t p=cwts.size(), x;
+    double t=this->uniform()*sm;
+    std::vector<size_t>::iterator k=ex.begin();
+    while(true) {
+      x = std::upper_bound(cwts.begin(), cwts.end(), t)-cwts.begin();
+      if(k==ex.end() || x<*k) break;
+      t += cwts[*k]-(*k ? cwts[*k-1] : 0.);
+      ++k;
+    }
+    if(x>=p) //rounding at the top: the last category not excluded
+      for(x=p-1; x>0 && std::binary_search(ex.begin(), ex.end(), x); x--);
+    return x;
+  }
+ protected:
+  std::vector<double> cwts; //cumulative weights
 };
 
 #ifdef RNG_random
@@ -92,7 +121,7 @@ class arn: public rn
 //  virtual size_t discrete() {return (dis)(gen);}
   virtual size_t discrete() {
     size_t p=wts.size(), x=0;
-    std::vector<int> vOut (p,0);
+    vOut.assign(p,0);
     ::rmultinom(1,&wts[0],p,&vOut[0]); 
     if(vOut[0]==0) for(size_t j=1;j<p;j++) x += j*vOut[j]; 
     return x;
@@ -118,9 +147,28 @@ class arn: public rn
     }
     return draw;
   }
+  //discrete draws with Rmath so its seeds are saved too
+  virtual void save(std::ostream& os) {
+    std::stringstream ss;
+    ss << gen << ' ' << nor;
+    ckput(os, ss.str());
+    unsigned int s1, s2;
+    ::get_seed(&s1, &s2);
+    ckput(os, s1); ckput(os, s2);
+  }
+  virtual void load(std::istream& is) {
+    std::string st;
+    ckget(is, st);
+    std::stringstream ss(st);
+    ss >> gen >> nor;
+    unsigned int s1=0, s2=0;
+    ckget(is, s1); ckget(is, s2);
+    ::set_seed(s1, s2);
+  }
  private:
   unsigned int n1, n2;
   std::vector<double> wts; 
+  std::vector<int> vOut; //multinomial draws, kept to not reallocate
   genD gen;
   norD nor;
   uniD uni;
@@ -161,7 +209,7 @@ class arn: public rn
   }
   virtual size_t discrete() {
     size_t p=wts.size(), x=0;
-    std::vector<int> vOut (p,0);
+    vOut.assign(p,0);
     ::rmultinom(1,&wts[0],p,&vOut[0]); 
     if(vOut[0]==0) for(size_t j=1;j<p;j++) x += j*vOut[j]; 
     return x;
@@ -177,6 +225,16 @@ class arn: public rn
   {::set_seed(n1, n2);}
   void get_seed(unsigned int* n1, unsigned int* n2) 
   {::get_seed(n1, n2);}
+  virtual void save(std::ostream& os) {
+    unsigned int s1, s2;
+    ::get_seed(&s1, &s2);
+    ckput(os, s1); ckput(os, s2);
+  }
+  virtual void load(std::istream& is) {
+    unsigned int s1=0, s2=0;
+    ckget(is, s1); ckget(is, s2);
+    ::set_seed(s1, s2);
+  }
   virtual std::vector<double> log_dirichlet(std::vector<double>& alpha){
     size_t k=alpha.size();
     std::vector<double> draw(k);
@@ -191,6 +249,7 @@ class arn: public rn
   }
  private:
   std::vector<double> wts; 
+  std::vector<int> vOut; //multinomial draws, kept to not reallocate
 };
 
 #else // YesRcpp
@@ -246,7 +305,7 @@ class arn: public rn
   } 
  virtual size_t discrete() {
     size_t p=wts.size(), x=0;
-    std::vector<int> vOut (p,0);
+    vOut.assign(p,0);
     R::rmultinom(1,&wts[0],p,&vOut[0]); 
     if(vOut[0]==0) for(size_t j=1;j<p;j++) x += j*vOut[j]; 
     return x;
@@ -300,14 +359,51 @@ class arn: public rn
       return -2; // never gets to this line: just working around the compiler warnings
     }
 
+    //.Random.seed, i.e., the state of R's generator
+    virtual void save(std::ostream& os) {
+      PutRNGstate();
+      Rcpp::IntegerVector seed=Rcpp::Environment::global_env()[".Random.seed"];
+      std::vector<int> s(seed.begin(), seed.end());
+      ckput(os, s);
+    }
+    virtual void load(std::istream& is) {
+      std::vector<int> s;
+      ckget(is, s);
+      Rcpp::Environment::global_env().assign(".Random.seed",
+					     Rcpp::IntegerVector(s.begin(), s.end()));
+      GetRNGstate();
+    }
     Rcpp::RNGScope get_state(void) { return RNGstate; }
     void set_state(Rcpp::RNGScope RNGstate) { this->RNGstate=RNGstate; }
   
  private:
   std::vector<double> wts;
+  std::vector<int> vOut; //multinomial draws, kept to not reallocate
   Rcpp::RNGScope RNGstate;
 };
 
 #endif 
 
+//counter-based uniforms: draw t of stream (a,b) under seed is the
+//splitmix64 hash of a key of the three and t, so a stream is the same
+//whichever thread draws it and in whatever order the streams are drawn
+class ctrrn
+{
+ public:
+  ctrrn(uint64_t seed, uint64_t a, uint64_t b): t(0) {
+    key=mix(seed+GOLDEN);
+    key=mix(key^(a+GOLDEN));
+    key=mix(key^(b+GOLDEN));
+  }
+  double uniform() {return (mix(key+(++t)*GOLDEN)>>11)*(1./9007199254740992.);}
+  static uint64_t mix(uint64_t z) {
+    z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+    z=(z^(z>>27))*0x94D049BB133111EBULL;
+    return z^(z>>31);
+  }
+ private:
+  static const uint64_t GOLDEN=0x9E3779B97F4A7C15ULL;
+  uint64_t key, t;
+};
+
 #endif 
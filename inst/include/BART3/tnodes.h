@@ -0,0 +1,99 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+#ifndef GUARD_tnodes_h
+#define GUARD_tnodes_h
+
+#include "tree.h"
+#include "treefuns.h"
+
+//the bottom nodes of a tree in the order of getbots updated by births
+//and deaths, and from them the bottom nodes that can split and the nog
+//nodes in the order of getnogs: so a move is proposed without walking
+//the tree and, once the vectors have grown, without allocation
+class tnodes {
+public:
+   tnodes():mv(0),mx(0),ml(0),mr(0),top(0),stale(true) {}
+   void init(tree& t);
+   tree::tree_cp gettop() {return top;}
+   void birth(tree::tree_p nx); //after nx is split
+   void death(tree::tree_p nx); //before the children of nx are removed
+   //rules changed under nx: bottom nodes may (not) split
+   void setstale(tree::tree_p nx) {stale=true; mv='r'; mx=nx;}
+   void update(xinfo& xi); //goodbots and nogs, if stale
+   size_t treesize() {return 2*bots.size()-1;}
+   tree::npv bots, goodbots, nogs;
+   //the last move: 'b' birth at mx, 'd' death at mx of ml and mr (now
+   //deleted) or 'r' rules changed under mx
+   char mv;
+   tree::tree_p mx, ml, mr;
+private:
+   tree::tree_cp top;
+   bool stale;
+};
+
+//--------------------------------------------------
+void tnodes::init(tree& t)
+{
+   top=&t;
+   if(bots.capacity()==0) { //so that births rarely reallocate
+      bots.reserve(32);
+      goodbots.reserve(32);
+      nogs.reserve(32);
+   }
+   bots.clear();
+   t.getbots(bots);
+   stale=true;
+}
+//--------------------------------------------------
+void tnodes::birth(tree::tree_p nx)
+{
+   tree::npv::iterator it=std::find(bots.begin(),bots.end(),nx);
+   *it=nx->getl();
+   bots.insert(it+1,nx->getr());
+   stale=true;
+   mv='b'; mx=nx;
+}
+//--------------------------------------------------
+void tnodes::death(tree::tree_p nx)
+{
+   tree::npv::iterator it=std::find(bots.begin(),bots.end(),nx->getl());
+   *it=nx;
+   bots.erase(it+1);
+   stale=true;
+   mv='d'; mx=nx; ml=nx->getl(); mr=nx->getr();
+}
+//--------------------------------------------------
+//a nog is found at its left child which is a bottom node
+void tnodes::update(xinfo& xi)
+{
+   if(!stale) return;
+   goodbots.clear();
+   nogs.clear();
+   for(size_t i=0;i<bots.size();i++) {
+      tree::tree_p b=bots[i], p=b->getp();
+      if(cansplit(b,xi)) goodbots.push_back(b);
+      if(p && b==p->getl() && p->getr()->getl()==0) nogs.push_back(p);
+   }
+   stale=false;
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include <map>
 #include <cmath>
 #include <cstddef>
+#include <algorithm>
 //#include "common.h"
 //--------------------------------------------------
 //xinfo xi, then xi[v][c] is the c^{th} cutpoint for variable v.
@@ -52,9 +53,9 @@ public:
    typedef std::vector<tree_p> npv; 
    typedef std::vector<tree_cp> cnpv;
    //contructors,destructors--------------------
-   tree(): theta(0.0),v(0),c(0),p(0),l(0),r(0) {}
-   tree(const tree& n): theta(0.0),v(0),c(0),p(0),l(0),r(0) {cp(this,&n);}
-   tree(double itheta): theta(itheta),v(0),c(0),p(0),l(0),r(0) {}
+   tree(): theta(0.0),v(0),c(0),p(0),l(0),r(0),exok(false) {}
+   tree(const tree& n): theta(0.0),v(0),c(0),p(0),l(0),r(0),exok(false) {cp(this,&n);}
+   tree(double itheta): theta(itheta),v(0),c(0),p(0),l(0),r(0),exok(false) {}
    void tonull(); //like a "clear", null tree has just one node
    ~tree() {tonull();}
    //operators----------
@@ -62,8 +63,8 @@ public:
    //interface--------------------
    //set
    void settheta(double theta) {this->theta=theta;}
-   void setv(size_t v) {this->v = v;}
-   void setc(size_t c) {this->c = c;}
+   void setv(size_t v) {this->v = v; if(l) {l->exreset(); r->exreset();}}
+   void setc(size_t c) {this->c = c; if(l) {l->exreset(); r->exreset();}}
    //get
    double gettheta() const {return theta;}
    size_t getv() const {return v;}
@@ -86,7 +87,13 @@ public:
    void getnodes(npv& v);         //get vector of all nodes
    void getnodes(cnpv& v) const;  //get vector of all nodes (const)
    tree_p bn(double *x,xinfo& xi); //find Bottom Node
+   bool splitson(std::vector<bool>& vf) const; //any split on a flagged variable
+   void setnodes(std::vector<node_info>& nv); //build from node info (getnodes order)
+   void save(std::ostream& os) const; //binary, for checkpoints
+   void load(std::istream& is);
    void rg(size_t v, int* L, int* U); //recursively find region [L,U] for var v
+   std::vector<size_t>& getex(xinfo& xi); //sorted variables with empty region
+   void exreset(); //forget getex here and below
    //node functions--------------------
    size_t nid() const; //nid of a node
    size_t depth();  //depth of a node
@@ -109,6 +116,10 @@ private:
    tree_p p; //parent
    tree_p l; //left child
    tree_p r; //right child
+   //variables exhausted at this node: the parent's and perhaps its
+   //split variable, found on first use and kept until a rule above changes
+   std::vector<size_t> ex;
+   bool exok;
    //utiity functions
    void cp(tree_p n,  tree_cp o); //copy tree
 };
@@ -321,6 +332,12 @@ tree::tree_p tree::bn(double *x,xinfo& xi)
    }
 }
 //--------------------
+bool tree::splitson(std::vector<bool>& vf) const
+{
+   if(l==0) return false;
+   return vf[v] || l->splitson(vf) || r->splitson(vf);
+}
+//--------------------
 //find region for a given variable
 void tree::rg(size_t v, int* L, int* U)
 {
@@ -340,6 +357,39 @@ void tree::rg(size_t v, int* L, int* U)
    }
 }
 //--------------------
+//variables whose region is empty at this node, i.e., those it can not
+//split on: a node has those of its parent and perhaps the parent's
+//split variable so only that region is found
+std::vector<size_t>& tree::getex(xinfo& xi)
+{
+   if(!exok) {
+      if(p==0) {
+         ex.clear();
+         for(size_t j=0;j<xi.size();j++) if(xi[j].size()==0) ex.push_back(j);
+      } else {
+         ex = p->getex(xi);
+         size_t pv = p->v;
+         int L=0, U=xi[pv].size()-1;
+         rg(pv,&L,&U);
+         if(U<L) {
+            std::vector<size_t>::iterator it=std::lower_bound(ex.begin(),ex.end(),pv);
+            if(it==ex.end() || *it!=pv) ex.insert(it,pv);
+         }
+      }
+      exok=true;
+   }
+   return ex;
+}
+//--------------------
+void tree::exreset()
+{
+   exok=false;
+   if(l) {
+      l->exreset();
+      r->exreset();
+   }
+}
+//--------------------
 //cut back to one node
 void tree::tonull()
 {
@@ -359,6 +409,7 @@ void tree::tonull()
    theta=0.0;
    v=0;c=0;
    p=0;l=0;r=0;
+   exok=false;
 }
 //--------------------
 //copy tree tree o to tree n
@@ -374,6 +425,7 @@ void tree::cp(tree_p n, tree_cp o)
    n->theta = o->theta;
    n->v = o->v;
    n->c = o->c;
+   n->exok = false;
 
    if(o->l) { //if o has children
       n->l = new tree;
@@ -411,8 +463,6 @@ std::ostream& operator<<(std::ostream& os, const tree& t)
 }
 std::istream& operator>>(std::istream& is, tree& t)
 {
-   size_t tid,pid; //tid: id of current node, pid: parent's id
-   std::map<size_t,tree::tree_p> pts;  //pointers to nodes indexed by node id
    size_t nn; //number of nodes
 
    t.tonull(); // obliterate old tree (if there)
@@ -433,10 +483,22 @@ std::istream& operator>>(std::istream& is, tree& t)
          return is;
       }
    }
+   t.setnodes(nv);
+   return is;
+}
+//--------------------
+//build the tree from node information in the order of getnodes
+void tree::setnodes(std::vector<node_info>& nv)
+{
+   size_t tid,pid; //tid: id of current node, pid: parent's id
+   std::map<size_t,tree::tree_p> pts;  //pointers to nodes indexed by node id
+
+   tonull(); // obliterate old tree (if there)
+
    //first node has to be the top one
-   pts[1] = &t; //careful! this is not the first pts, it is pointer of id 1.
-   t.setv(nv[0].v); t.setc(nv[0].c); t.settheta(nv[0].theta);
-   t.p=0;
+   pts[1] = this; //careful! this is not the first pts, it is pointer of id 1.
+   setv(nv[0].v); setc(nv[0].c); settheta(nv[0].theta);
+   p=0;
 
    //now loop through the rest of the nodes knowing parent is already there.
    for(size_t i=1;i!=nv.size();i++) {
@@ -453,7 +515,33 @@ std::istream& operator>>(std::istream& is, tree& t)
       }
       np->p = pts[pid];
    }
-   return is;
+}
+//--------------------
+//binary copy of the tree for checkpoints (ckpt.h)
+void tree::save(std::ostream& os) const
+{
+   cnpv nds;
+   getnodes(nds);
+   ckput(os, nds.size());
+   for(size_t i=0;i<nds.size();i++) {
+      ckput(os, nds[i]->nid());
+      ckput(os, nds[i]->v);
+      ckput(os, nds[i]->c);
+      ckput(os, nds[i]->theta);
+   }
+}
+void tree::load(std::istream& is)
+{
+   size_t nn=0;
+   ckget(is, nn);
+   std::vector<node_info> nv(nn);
+   for(size_t i=0;i<nn;i++) {
+      ckget(is, nv[i].id);
+      ckget(is, nv[i].v);
+      ckget(is, nv[i].c);
+      ckget(is, nv[i].theta);
+   }
+   if(is && nn) setnodes(nv);
 }
 //--------------------
 //add children to bot node *np
@@ -88,27 +88,17 @@ void fit(tree& t, xinfo& xi, size_t p, size_t n, double *x,  double* fv)
 //does this bottom node n have any variables it can split on.
 bool cansplit(tree::tree_p n, xinfo& xi)
 {
-   int L,U;
-   bool v_found = false; //have you found a variable you can split on
-   size_t v=0;
-   while(!v_found && (v < xi.size())) { //invar: splitvar not found, vars left
-      L=0; U = xi[v].size()-1;
-      n->rg(v,&L,&U);
-      if(U>=L) v_found=true;
-      v++;
-   }
-   return v_found;
+   return n->getex(xi).size() < xi.size();
 }
 //--------------------------------------------------
 //find variables n can split on, put their indices in goodvars
 void getgoodvars(tree::tree_p n, xinfo& xi,  std::vector<size_t>& goodvars)
 {
    goodvars.clear();
-   int L,U;
-   for(size_t v=0;v!=xi.size();v++) {//try each variable
-      L=0; U = xi[v].size()-1;
-      n->rg(v,&L,&U);
-      if(U>=L) goodvars.push_back(v);
+   std::vector<size_t>& ex = n->getex(xi);
+   for(size_t v=0, k=0;v!=xi.size();v++) {//all but the exhausted variables
+      if(k<ex.size() && ex[k]==v) k++;
+      else goodvars.push_back(v);
    }
 }
 
@@ -58,7 +58,7 @@ double right_tgamma_beta(double shape, double rate)
         }
     }
 
-    return R::beta(a, k);
+    return R::rbeta(a, k);
 }
 
 double rtgamma_rate(double shape, double rate, double right_t)
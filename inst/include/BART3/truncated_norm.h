@@ -71,10 +71,9 @@ double tnorm(double left, rn& gen)
                 #ifndef USE_R
 		fprintf(stderr, "left < 0; count: %i\n", count);
                 #else
-		rprintf("left < 0; count: %i\n", count);
+		Rprintf("left < 0; count: %i\n", count);
                 #endif
 	    }
-	    p
             #endif
         }
     }
@@ -0,0 +1,95 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+#ifndef GUARD_tshape_h
+#define GUARD_tshape_h
+
+#include "tree.h"
+
+//shape of each of m trees: bottom nodes by depth updated by births/deaths
+class tshape {
+public:
+   tshape():m(0) {}
+   void init(std::vector<tree>& t);
+   size_t getm() {return m;}
+   void birth(size_t j, size_t d); //bottom node at depth d of tree j split
+   void death(size_t j, size_t d); //nog node at depth d of tree j collapsed
+   size_t nbots(size_t j) {return nb[j];}
+   size_t treesize(size_t j) {return 2*nb[j]-1;}
+   size_t depth(size_t j) {return bd[j].size()-1;}
+   //histograms over the m trees, the last bin is that value or more
+   void hist(std::vector<size_t>& dh, std::vector<size_t>& lh);
+private:
+   size_t m;
+   std::vector<size_t> nb; //number of bottom nodes
+   std::vector< std::vector<size_t> > bd; //bd[j][d]: bottom nodes at depth d
+};
+
+//--------------------------------------------------
+void tshape::init(std::vector<tree>& t)
+{
+   m=t.size();
+   nb.assign(m, 0);
+   bd.assign(m, std::vector<size_t>(1, 0));
+   tree::npv bots;
+   for(size_t j=0;j<m;j++) {
+      bd[j].reserve(16); //deeper trees are rare: births don't reallocate
+      bots.clear();
+      t[j].getbots(bots);
+      nb[j]=bots.size();
+      for(size_t i=0;i<bots.size();i++) {
+	 size_t d=bots[i]->depth();
+	 if(bd[j].size()<d+1) bd[j].resize(d+1, 0);
+	 bd[j][d]++;
+      }
+   }
+}
+//--------------------------------------------------
+void tshape::birth(size_t j, size_t d)
+{
+   std::vector<size_t>& b=bd[j];
+   b[d]--;
+   if(b.size()<d+2) b.push_back(0);
+   b[d+1]+=2;
+   nb[j]++;
+}
+//--------------------------------------------------
+void tshape::death(size_t j, size_t d)
+{
+   std::vector<size_t>& b=bd[j];
+   b[d+1]-=2;
+   b[d]++;
+   while(b.back()==0) b.pop_back();
+   nb[j]--;
+}
+//--------------------------------------------------
+void tshape::hist(std::vector<size_t>& dh, std::vector<size_t>& lh)
+{
+   size_t nd=dh.size(), nl=lh.size();
+   std::fill(dh.begin(), dh.end(), 0);
+   std::fill(lh.begin(), lh.end(), 0);
+   for(size_t j=0;j<m;j++) {
+      dh[std::min(depth(j), nd-1)]++;
+      lh[std::min(nb[j], nl)-1]++;
+   }
+}
+
+#endif
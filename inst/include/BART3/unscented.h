@@ -22,7 +22,11 @@
 #ifndef GUARD_vs_h
 #define GUARD_vs_h
 
+#ifdef NoRcpp
+#include <Eigen/Dense>
+#else
 #include "RcppEigen.h"
+#endif
 
 typedef Eigen::Map<Eigen::MatrixXd> mm;
 typedef Eigen::VectorXd vm;
@@ -25,7 +25,11 @@
 
 #include "polyagamma_wrapper.h"
 #include "inverse_gaussian.h"
+#ifdef NoRcpp
+#include <Eigen/Dense>
+#else
 #include "RcppEigen.h"
+#endif
 
 typedef Eigen::MatrixXd mm;
 typedef Eigen::VectorXd vm;
@@ -49,6 +53,9 @@ public:
   void draw_tau2_ln(rn &gen);
   void draw_lambda_lnLASSO(rn& gen);
   void set_R(size_t _R);
+  //checkpoints (ckpt.h): the draws, not the settings
+  void save(std::ostream& os);
+  bool load(std::istream& is);
 protected:
   size_t sparse;
   size_t p;
@@ -73,9 +80,15 @@ protected:
   double max_psi;
   bool lasso;
   double lambda;
+  //scratch for the draws, kept to not reallocate
+  std::vector<double> _theta, lambda_g, theta_g, lwt_g;
+  PolyaGamma dv;
+  PolyaGammaApproxSP sp;
+  void log_dirichlet(std::vector<double>& alpha, std::vector<double>& lpv, rn& gen);
 };
 
-vs::vs(size_t _sparse, size_t _p):grp(0)
+vs::vs(size_t _sparse, size_t _p):theta(0.),lse(0.),tau2(1.),grp(0),R(0),
+  max_psi(0.),lambda(0.),dv(1000)
 {
   this->isOn=false;
   this->sparse=_sparse;
@@ -155,22 +168,32 @@ void vs::setvs_ln(double _bprvar, double _tprprm, mm _an, size_t _noan, bool _la
 //draw variable splitting probabilities from Dirichlet (Linero, 2018)
 void vs::draw_s_dart(std::vector<double>& lpv, std::vector<size_t>& nv, rn& gen){
 // Now draw s, the vector of splitting probabilities
-  std::vector<double> _theta(p);
+  _theta.resize(p);
   for(size_t j=0;j<p;j++) _theta[j]=theta/(double)p+(double)nv[j];
   //gen.set_alpha(_theta);
-  lpv=gen.log_dirichlet(_theta);
+  log_dirichlet(_theta,lpv,gen);
+}
+
+//as rn::log_dirichlet, but into lpv
+void vs::log_dirichlet(std::vector<double>& alpha, std::vector<double>& lpv, rn& gen)
+{
+  size_t k=alpha.size();
+  lpv.resize(k);
+  for(size_t j=0;j<k;j++) lpv[j]=gen.log_gamma(alpha[j]);
+  double lse=log_sum_exp(lpv);
+  for(size_t j=0;j<k;j++) lpv[j] -= lse;
 }
 
 void vs::draw_s_grp_dart(std::vector<size_t>& nv, std::vector<double>& lpv, rn& gen, double *grp){
   size_t p=nv.size();
 // Now draw s, the vector of splitting probabilities
-  std::vector<double> _theta(p);
+  _theta.resize(p);
   for(size_t j=0;j<p;j++) {
     if(grp) _theta[j]=theta/(rho*grp[j])+(double)nv[j];
     else _theta[j]=theta/rho+(double)nv[j];
   }
   //gen.set_alpha(_theta);
-  lpv=gen.log_dirichlet(_theta);
+  log_dirichlet(_theta,lpv,gen);
 }
 
 void vs::draw_theta0_dart(std::vector<double>& lpv,rn& gen){
@@ -182,9 +205,9 @@ void vs::draw_theta0_dart(std::vector<double>& lpv,rn& gen){
   if(!const_theta){
     double sumlpv=0.,lse;
     
-    std::vector<double> lambda_g (1000,0.);
-    std::vector<double> theta_g (1000,0.);
-    std::vector<double> lwt_g (1000,0.);
+    lambda_g.resize(1000);
+    theta_g.resize(1000);
+    lwt_g.resize(1000);
     for(size_t j=0;j<p;j++) sumlpv+=lpv[j];
     for(size_t k=0;k<1000;k++){
       lambda_g[k]=(double)(k+1)/1001.;
@@ -215,7 +238,7 @@ void vs::draw_s_ln(std::vector<size_t>& nv, std::vector<double>& lpv, rn &gen)
     double kappa=(double)nv[j]-0.5*(double)R;
     double omega;
     // Draw Polya-gamma
-    rpg_hybrid(omega,(double)R,xi,gen);
+    rpg_hybrid(omega,(double)R,xi,gen,dv,sp);
     // Draw psi[j]
     if(noan!=0) psi_prior_mean = an.row(j)*beta;
     double psiVar = tau2/(1.+tau2*omega);
@@ -300,4 +323,27 @@ void vs::set_R(size_t _R)
   this->R=_R;
 }
 
+void vs::save(std::ostream& os)
+{
+  ckput(os, isOn); ckput(os, theta); ckput(os, lse); ckput(os, tau2);
+  ckput(os, max_psi); ckput(os, lambda); ckput(os, R);
+  vm *v[4]={&beta, &psi, &sig2Inv, &resid};
+  for(size_t k=0;k<4;k++)
+    ckput(os, std::vector<double>(v[k]->data(), v[k]->data()+v[k]->size()));
+}
+
+bool vs::load(std::istream& is)
+{
+  ckget(is, isOn); ckget(is, theta); ckget(is, lse); ckget(is, tau2);
+  ckget(is, max_psi); ckget(is, lambda); ckget(is, R);
+  vm *v[4]={&beta, &psi, &sig2Inv, &resid};
+  std::vector<double> x;
+  for(size_t k=0;k<4;k++) {
+    ckget(is, x);
+    v[k]->resize(x.size());
+    for(size_t j=0;j<x.size();j++) (*v[k])[j]=x[j];
+  }
+  return (bool)is;
+}
+
 #endif
@@ -28,7 +28,11 @@
 #include "DPMNoGa.h"
 #endif
 
+#include "cFOREST.h"
 #include "cEXPVALUE.h"
+#include "cTREESHAP.h"
+#include "cREADTREES.h"
+#include "cMAKECUTS.h"
 #include "cgbart.h"
 #include "cpwbart.h"
 #include "chotdeck.h"
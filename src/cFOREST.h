@@ -0,0 +1,102 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+//the trees of a treedraws list (with its cutpoints) in a forest, with
+//the covers if treedraws has them (gbart(treecover=1 or 2))
+void treedraws2forest(SEXP _itrees, forest& f)
+{
+   Rcpp::List trees(_itrees);
+   Rcpp::List ixi(Rcpp::wrap(trees["cutpoints"]));
+   size_t p = ixi.size();
+   xinfo xi;
+   xi.resize(p);
+   for(size_t i=0;i<p;i++) {
+      Rcpp::NumericVector cutv(ixi[i]);
+      xi[i].resize(cutv.size());
+      std::copy(cutv.begin(),cutv.end(),xi[i].begin());
+   }
+   Rcpp::CharacterVector itrees(Rcpp::wrap(trees["trees"]));
+   std::string itv(itrees[0]);
+   std::stringstream ttss(itv), ccss;
+   bool cover = trees.containsElementNamed("cover");
+   if(cover) {
+      Rcpp::CharacterVector icover(Rcpp::wrap(trees["cover"]));
+      ccss.str(std::string(icover[0]));
+   }
+   if(!f.read(ttss,xi,cover ? &ccss : 0))
+      Rcpp::stop("the trees of treedraws could not be read");
+}
+
+
+void forest_finalize(SEXP _ptr)
+{
+   forest *f = (forest*)R_ExternalPtrAddr(_ptr);
+   if(f) delete f;
+   R_ClearExternalPtr(_ptr);
+}
+
+//the forest of a treedraws list, or of a bart_forest (R/bart_forest.R):
+//that is the treedraws list with ptr, an external pointer to its forest
+//read once by cFOREST; after saveRDS/readRDS ptr is nil and the forest
+//is read again from the list and kept in ptr.  With x.train (p x n, n>0)
+//the covers are counted into tmp, a copy, so a bart_forest is unchanged
+const forest& getforest(SEXP _itrees, forest& tmp,
+			Rcpp::NumericMatrix* x=0, int tc=1)
+{
+   const forest *pf = &tmp;
+   if(Rf_inherits(_itrees, "bart_forest")) {
+      Rcpp::List trees(_itrees);
+      SEXP _ptr = trees["ptr"];
+      if(TYPEOF(_ptr)!=EXTPTRSXP)
+	 Rcpp::stop("the ptr of bart_forest is not an external pointer");
+      forest *f = (forest*)R_ExternalPtrAddr(_ptr);
+      if(!f) { //owned by ptr only once it is read
+	 std::unique_ptr<forest> g(new forest);
+	 treedraws2forest(_itrees,*g);
+	 f = g.release();
+	 R_SetExternalPtrAddr(_ptr, f);
+	 R_RegisterCFinalizerEx(_ptr, forest_finalize, TRUE);
+      }
+      pf = f;
+   }
+   else treedraws2forest(_itrees,tmp);
+   if(x && x->ncol()>0) {
+      if((size_t)x->nrow()!=pf->getp())
+	 Rcpp::stop("x.train must have the columns of the trees");
+      if(pf!=&tmp) tmp = *pf;
+      tmp.setcover(x->ncol(),&(*x)[0],tc);
+      pf = &tmp;
+   }
+   return *pf;
+}
+
+//a bart_forest's ptr: the forest of treedraws read once, deleted by the
+//finalizer when the R object is garbage collected
+RcppExport SEXP cFOREST(
+   SEXP _itrees			//treedraws list from gbart
+)
+{
+   BEGIN_RCPP
+   std::unique_ptr<forest> f(new forest);
+   treedraws2forest(_itrees,*f);
+   return Rcpp::XPtr<forest>(f.release(), true);
+   END_RCPP
+}
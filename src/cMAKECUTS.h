@@ -0,0 +1,57 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+//the cutpoints of bartModelMatrix from makecuts (cutpoints.h): xinfo is
+//p x numcut with NA after the nc cutpoints of a variable and rm.const
+//is 1 for a constant variable
+RcppExport SEXP cMAKECUTS(
+   SEXP _ix,			//x matrix, n x p
+   SEXP _inumcut,		//number of cutpoints
+   SEXP _iusequants,		//quantiles rather than an even grid
+   SEXP _icont,			//an even grid even with few values
+   SEXP _isketch,		//size of the quantile sketch
+   SEXP _itc			//thread count
+)
+{
+   Rcpp::NumericMatrix x(_ix);
+   size_t n = x.nrow(), p = x.ncol();
+   size_t numcut = Rcpp::as<int>(_inumcut);
+   bool usequants = Rcpp::as<int>(_iusequants)==1;
+   bool cont = Rcpp::as<int>(_icont)==1;
+   size_t k = Rcpp::as<int>(_isketch);
+   int tc = Rcpp::as<int>(_itc);
+
+   xinfo xi;
+   std::vector<int> nc, rm;
+   makecuts(n,p,&x[0],numcut,usequants,cont,xi,nc,rm,tc,k);
+
+   Rcpp::NumericMatrix xinf(p, numcut);
+   std::fill(xinf.begin(), xinf.end(), NA_REAL);
+   for(size_t j=0;j<p;j++)
+      for(size_t i=0;i<xi[j].size() && i<numcut;i++)
+	 if(xi[j][i]==xi[j][i]) xinf(j,i)=xi[j][i];
+
+   Rcpp::List ret;
+   ret["xinfo"]=xinf;
+   ret["numcut"]=Rcpp::wrap(nc);
+   ret["rm.const"]=Rcpp::wrap(rm);
+   return ret;
+}
@@ -0,0 +1,64 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+//the nodes of the tree draws, one row per node that exists, with R
+//indices; the covers are counted from x.train if it has rows, else
+//they are those kept with the draws if any
+RcppExport SEXP cREADTREES(
+   SEXP _itrees,		//treedraws list from gbart
+   SEXP _ix,			//x.train, transposed to p x n, for the covers
+   SEXP _itc			//thread count
+)
+{
+   BEGIN_RCPP
+   int tc = Rcpp::as<int>(_itc);
+   Rcpp::NumericMatrix x(_ix);
+   forest g;
+   const forest& f = getforest(_itrees,g,&x,tc);
+
+   size_t nd = f.getnd(), m = f.getm(), K = f.v.size();
+   bool coverage = f.hascover();
+
+   Rcpp::IntegerVector draw(K), tree(K), node(K), var(K);
+   Rcpp::NumericVector cut(K), leaf(K);
+   for(size_t i=0;i<nd;i++)
+      for(size_t j=0;j<m;j++)
+	 for(size_t q=f.tbeg(i,j);q<f.tend(i,j);q++) {
+	    draw[q]=i+1; tree[q]=j+1; node[q]=f.id[q];
+	    if(f.v[q]<0) { //a leaf
+	       var[q]=NA_INTEGER; cut[q]=NA_REAL; leaf[q]=f.theta[q];
+	    }
+	    else {
+	       var[q]=f.v[q]+1; cut[q]=f.c[q]; leaf[q]=NA_REAL;
+	    }
+	 }
+
+   Rcpp::List ret;
+   ret["draw"]=draw;
+   ret["tree"]=tree;
+   ret["node"]=node;
+   ret["var"]=var;
+   ret["cut"]=cut;
+   ret["leaf"]=leaf;
+   if(coverage) ret["cover"]=Rcpp::wrap(f.cover);
+   return ret;
+   END_RCPP
+}
@@ -0,0 +1,53 @@
+/*
+ *  sparseBART: sparse Bayesian Additive Regression Trees
+ *  Copyright (C) 2021 Charles Spanbauer
+ *
+ *  This file is part of sparseBART.
+ *
+ *  sparseBART is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  sparseBART is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with sparseBART; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/GPL-3
+ */
+
+//posterior draws of the TreeSHAP values of each row of xtest: see
+//forest::shap; bias is the cover weighted mean of each draw
+RcppExport SEXP cTREESHAP(
+   SEXP _itrees,		//treedraws list from gbart
+   SEXP _ix,			//x.train, transposed to p x n, for the covers
+   SEXP _ixp,			//x.test, transposed to p x np
+   SEXP _itc			//thread count
+)
+{
+   BEGIN_RCPP
+   int tc = Rcpp::as<int>(_itc);
+   Rcpp::NumericMatrix x(_ix), xp(_ixp);
+   forest g;
+   const forest& f = getforest(_itrees,g,&x,tc);
+
+   size_t nd = f.getnd(), p = f.getp(), np = xp.ncol();
+   if((size_t)xp.nrow()!=p)
+      Rcpp::stop("x.test must have the columns of the trees");
+   if(!f.hascover()) Rcpp::stop("x.train is needed for the covers");
+
+   Rcpp::NumericVector phi(Rcpp::Dimension(nd, np, p)), bias(nd);
+   f.shap(np,&xp[0],&phi[0],tc);
+   std::vector<int> mask(p, 0);
+   std::vector<double> xt(p, 0.);
+   f.expvalue(1,&xt[0],&mask[0],&bias[0],tc);
+
+   Rcpp::List ret;
+   ret["shap"] = phi;
+   ret["bias"] = bias;
+   return ret;
+   END_RCPP
+}
@@ -21,16 +21,83 @@
 
 #include "RcppEigen.h"
 
-#ifndef NoRcpp
-
-#define TRDRAW(a, b) trdraw(a, b)
-#define TEDRAW(a, b) tedraw(a, b)
-#define XV(a, b) xv(a, b)
-#define IMPUTE_DRAW1(a, b) impute_draw1(a, b)
-#define IMPUTE_DRAW2(a, b) impute_draw2(a, b)
+//keeps the draws of gbart in the matrices returned to R
+class Rgbartsink: public gbartsink
+{
+ public:
+  virtual void init(const gbartcfg& cfg, size_t start) {
+    gbartsink::init(cfg, start);
+    sdraw=Rcpp::NumericVector(nsigma);
+    trdraw=Rcpp::NumericMatrix(nkeep, n);
+    tedraw=Rcpp::NumericMatrix(nkeep, np);
+    impute_draw1=Rcpp::NumericMatrix(nkeep, n);
+    impute_draw2=Rcpp::NumericMatrix(nkeep, n);
+    varcnt=Rcpp::IntegerMatrix(nkeep, p);
+    varprb=Rcpp::NumericMatrix(nkeep, p);
+    diagnostics=Rcpp::NumericMatrix(ndiag, 11);
+    //histograms of depth 0, ..., 10+ and leaves 1, ..., 32+ over the trees
+    shdepth=Rcpp::IntegerMatrix(ndiag, 11);
+    shleaves=Rcpp::IntegerMatrix(ndiag, 32);
+    trdepth=Rcpp::IntegerMatrix(treeshape ? nkeep : 0, m);
+    trleaves=Rcpp::IntegerMatrix(treeshape ? nkeep : 0, m);
+    dhist.resize(11);
+    lhist.resize(32);
+    putheaders(treess, coverss, *this);
+  }
+  virtual void cutpoints(xinfo& xi) {
+    xiret=Rcpp::List(xi.size());
+    for(size_t i=0;i<xi.size();i++) {
+      Rcpp::NumericVector vtemp(xi[i].size());
+      std::copy(xi[i].begin(),xi[i].end(),vtemp.begin());
+      xiret[i] = Rcpp::NumericVector(vtemp);
+    }
+  }
+  virtual void sigma(size_t i, double s) {sdraw[i]=s;}
+  virtual void train(size_t d, const double* f)
+  {for(size_t k=0; k<n; k++) trdraw(d, k)=f[k];}
+  virtual void test(size_t d, const double* f)
+  {for(size_t k=0; k<np; k++) tedraw(d, k)=f[k];}
+  virtual void impute(size_t d, const double* x1, const double* x2) {
+    for(size_t k=0; k<n; k++) {
+      impute_draw1(d, k)=x1[k];
+      impute_draw2(d, k)=x2[k];
+    }
+  }
+  virtual void trees(size_t d, heterbart& bm) {
+    std::vector<size_t>& nv=bm.getnv();
+    std::vector<double>& pv=bm.getpv();
+    for(size_t j=0; j<m; j++) treess << bm.gettree(j);
+    if(treecover) putcover(coverss, bm, treecover);
+    for(size_t h=0; h<p; h++) {
+      varcnt(d, h)=nv[h];
+      varprb(d, h)=pv[h];
+    }
+    if(treeshape) {
+      tshape& ts=bm.getts();
+      for(size_t j=0; j<m; j++) {
+	trdepth(d, j)=ts.depth(j);
+	trleaves(d, j)=ts.nbots(j);
+      }
+    }
+  }
+  virtual void diag(size_t g, const double* dg, heterbart& bm) {
+    for(size_t j=0; j<11; j++) diagnostics(g, j)=dg[j];
+    bm.getts().hist(dhist, lhist);
+    for(size_t j=0; j<11; j++) shdepth(g, j)=dhist[j];
+    for(size_t j=0; j<32; j++) shleaves(g, j)=lhist[j];
+  }
+  Rcpp::NumericVector sdraw;
+  Rcpp::NumericMatrix trdraw, tedraw, impute_draw1, impute_draw2, varprb,
+    diagnostics;
+  Rcpp::IntegerMatrix varcnt, shdepth, shleaves, trdepth, trleaves;
+  std::stringstream treess, coverss;
+  Rcpp::List xiret;
+ private:
+  std::vector<size_t> dhist, lhist;
+};
 
 RcppExport SEXP cgbart(
-   SEXP _type,          //1:wbart, 2:pbart, 3:lbart
+   SEXP _type,          //1:wbart, 2:pbart, 3:lbart, 4:pgbart
    SEXP _in,            //number of observations in training data
    SEXP _ip,            //dimension of x
    SEXP _inp,           //number of observations in test data
@@ -72,553 +139,127 @@ RcppExport SEXP cgbart(
    SEXP _shards,
    SEXP _impute_mult, // integer vector of column indicators for missing covariates
    SEXP _impute_miss, // integer vector of row indicators for missing values
-   SEXP _impute_prior // matrix of prior missing imputation probability
+   SEXP _impute_prior, // matrix of prior missing imputation probability
+   SEXP _idiagevery,    //diagnostics every diagevery iterations, 0: none
+   SEXP _itreeshape,    //keep leaves and depth of each tree with the tree draws
+   SEXP _itreecover,    //keep the counts (1) and sums of w (2) at each node, 0: none
+   SEXP _icheckpoint,   //checkpoint file, "": none
+   SEXP _icheckevery,   //checkpoint every checkevery iterations, 0: none
+   SEXP _iresume,       //checkpoint file to resume from, "": none
+   SEXP _imoves,        //move probabilities: birth/death, change, swap
+   SEXP _iadapt         //adapt the move probabilities during burn-in
 )
 {
+   BEGIN_RCPP
    //process args
-   int type = Rcpp::as<int>(_type), shards = Rcpp::as<int>(_shards);
-   size_t n = Rcpp::as<int>(_in);
-   size_t p = Rcpp::as<int>(_ip);
-   size_t np = Rcpp::as<int>(_inp);
- 
-/*
-  // the pointer from a vector should be equivalent to the pointer from a matrix
-  // since, as far as R is concerned, a matrix is just a fancy vector
-   Rcpp::NumericVector  xv(_ix);
-   double *ix = &xv[0];
-*/
-   
+   gbartcfg cfg;
+   cfg.type = Rcpp::as<int>(_type);
+   cfg.shards = Rcpp::as<int>(_shards);
+   cfg.n = Rcpp::as<int>(_in);
+   size_t p = cfg.p = Rcpp::as<int>(_ip);
+   cfg.np = Rcpp::as<int>(_inp);
    Rcpp::NumericMatrix xv(_ix); // transposed:  p rows, n columns
-   double *ix = &XV(0, 0);
-
-/*
-   size_t K;
-   Rcpp::List impute(_impute);
-   Rcpp::IntegerVector impute_mult, impute_miss;
-//   Rcpp::NumericVector impute_y;
-//   Rcpp::NumericMatrix impute_prior;
-   if(impute.size()==0) K=0;
-   else {
-     K=impute_mult.size();
-     impute_mult=impute["mult"];
-     impute_miss=impute["miss"];
-//     impute_prior=impute["prior"];
-//     impute_y=impute["y"];
-   }
-*/
+   double *ix = &xv(0, 0);
    Rcpp::IntegerVector impute_mult(_impute_mult); // integer vector of column indicators for missing covariates
    size_t K = impute_mult.size(); // number of columns to impute
    Rcpp::IntegerVector impute_miss(_impute_miss); // length n: integer vector of row indicators for missing values
    Rcpp::NumericMatrix impute_prior(_impute_prior); // n X K: matrix of prior missing imputation probability
-   Rcpp::NumericVector impute_post(K); // length K: double vector of posterior missing imputation probability
-   Rcpp::NumericVector impute_fhat(K); 
-   double *impute_fhat_ptr = 0, *impute_Xrow_ptr = 0;
-   if(K>0) impute_fhat_ptr = &impute_fhat[0];
+   if(K>0) {
+     cfg.impute_mult.assign(impute_mult.begin(), impute_mult.end());
+     cfg.impute_miss.assign(impute_miss.begin(), impute_miss.end());
+     cfg.impute_prior.assign(impute_prior.begin(), impute_prior.end());
+   }
    Rcpp::NumericVector  yv(_iy); 
    double *iy = &yv[0];
    Rcpp::NumericVector  xpv(_ixp);
    double *ixp = &xpv[0];
-   //Rcpp::NumericVector z_train(_z_train);
-   //double *z = &z_train[0];
-   //Rcpp::IntegerVector z_draw(_z_draw);
-   size_t m = Rcpp::as<int>(_im);
+   cfg.m = Rcpp::as<int>(_im);
    Rcpp::IntegerVector _nc(_inc);
-   int *numcut = &_nc[0];
-   size_t nd = Rcpp::as<int>(_ind);
-   size_t burn = Rcpp::as<int>(_iburn);
-   size_t thin = Rcpp::as<int>(_ithin);
-   double mybeta = Rcpp::as<double>(_ipower);
-   double alpha = Rcpp::as<double>(_ibase);
-   double Offset = Rcpp::as<double>(_Offset);
-   double tau = Rcpp::as<double>(_itau);
-   double nu = Rcpp::as<double>(_inu);
-   double lambda = Rcpp::as<double>(_ilambda);
-   double sigma=Rcpp::as<double>(_isigest);
+   cfg.numcut.assign(_nc.begin(), _nc.end());
+   cfg.nd = Rcpp::as<int>(_ind);
+   cfg.burn = Rcpp::as<int>(_iburn);
+   cfg.thin = Rcpp::as<int>(_ithin);
+   cfg.power = Rcpp::as<double>(_ipower);
+   cfg.base = Rcpp::as<double>(_ibase);
+   cfg.Offset = Rcpp::as<double>(_Offset);
+   cfg.tau = Rcpp::as<double>(_itau);
+   cfg.nu = Rcpp::as<double>(_inu);
+   cfg.lambda = Rcpp::as<double>(_ilambda);
+   cfg.sigma=Rcpp::as<double>(_isigest);
    Rcpp::NumericVector  wv(_iw);
    double *iw = &wv[0];
-   int treeinit=Rcpp::as<int>(_treeinit); 
-   //Rcpp::CharacterVector itrees(_itrees); 
-   //std::string itv(itrees[0]);
-   size_t sparse = Rcpp::as<int>(_isparse);
-   double a = Rcpp::as<double>(_ia);
-   double b = Rcpp::as<double>(_ib);
-//   Rcpp::NumericVector irho(_irho);
-//   double *rho = &irho[0];
-   double rho = Rcpp::as<double>(_irho);
-   bool aug;
-   if(Rcpp::as<int>(_iaug)==1) aug=true;
-   else aug=false;
-   Eigen::Map<Eigen::MatrixXd> an = Rcpp::as<Eigen::Map<Eigen::MatrixXd> >(_ian);
-   size_t noan = Rcpp::as<int>(_inoan);
-   double bprvar = Rcpp::as<double>(_ibprvar);
-   double tprprm = Rcpp::as<double>(_itprprm);
-   size_t pivot = Rcpp::as<double>(_ipivot);
+   if(Rcpp::as<int>(_treeinit)==1) {
+     Rcpp::CharacterVector itrees(_itrees); 
+     cfg.trees = std::string(itrees[0]);
+   }
+   cfg.sparse = Rcpp::as<int>(_isparse);
+   cfg.a = Rcpp::as<double>(_ia);
+   cfg.b = Rcpp::as<double>(_ib);
+   cfg.rho = Rcpp::as<double>(_irho);
+   cfg.aug = Rcpp::as<int>(_iaug)==1;
+   cfg.an = Rcpp::as<Eigen::Map<Eigen::MatrixXd> >(_ian);
+   cfg.noan = Rcpp::as<int>(_inoan);
+   cfg.bprvar = Rcpp::as<double>(_ibprvar);
+   cfg.tprprm = Rcpp::as<double>(_itprprm);
    Rcpp::NumericVector varprob(_varprob);
-   double theta = Rcpp::as<double>(_itheta);
-   double omega = Rcpp::as<double>(_iomega);
-   Rcpp::IntegerVector _grp(_igrp);
-   int *grp = &_grp[0];
-//   if(rho==0.) for(size_t i=0; i<p; ++i) rho += (1./grp[i]);
-   size_t nkeeptrain = nd/thin;     //Rcpp::as<int>(_inkeeptrain);
-   size_t nkeeptest = nd/thin;      //Rcpp::as<int>(_inkeeptest);
-   size_t nkeeptreedraws = nd/thin; //Rcpp::as<int>(_inkeeptreedraws);
-   size_t printevery = Rcpp::as<int>(_inprintevery);
-   Rcpp::NumericMatrix varprb(nkeeptreedraws,p);
-   Rcpp::IntegerMatrix varcnt(nkeeptreedraws,p);
+   cfg.theta = Rcpp::as<double>(_itheta);
+   cfg.omega = Rcpp::as<double>(_iomega);
+   cfg.printevery = Rcpp::as<int>(_inprintevery);
+   cfg.diagevery = Rcpp::as<int>(_idiagevery);
+   cfg.treeshape = Rcpp::as<int>(_itreeshape)==1;
+   cfg.treecover = Rcpp::as<int>(_itreecover);
+   cfg.checkpoint = Rcpp::as<std::string>(_icheckpoint);
+   cfg.checkevery = Rcpp::as<int>(_icheckevery);
+   cfg.resume = Rcpp::as<std::string>(_iresume);
+   Rcpp::NumericVector moves(_imoves);
+   cfg.pbd = moves[0];
+   cfg.pchange = moves[1];
+   cfg.adapt = Rcpp::as<int>(_iadapt)==1;
    Rcpp::NumericMatrix Xinfo(_Xinfo);
-   Rcpp::NumericVector sdraw(nd+burn);
-   Rcpp::NumericVector accept(nd+burn);
-   Rcpp::NumericMatrix trdraw(nkeeptrain,n);
-   Rcpp::NumericMatrix tedraw(nkeeptest,np);
-   Rcpp::NumericMatrix impute_draw1(nkeeptrain, n);
-   Rcpp::NumericMatrix impute_draw2(nkeeptrain, n);
-   //Rcpp::NumericVector impute_draw(Rcpp::Dimension(nkeeptrain, n, K));
-
-   //random number generation
-   arn gen;
-
-   heterbart bm(m);
-
    if(Xinfo.size()>0) {
-     xinfo _xi;
-     _xi.resize(p);
+     cfg.xi.resize(p);
      for(size_t i=0;i<p;i++) {
-       _xi[i].resize(numcut[i]);
-       for(size_t j=0;j<numcut[i];j++) _xi[i][j]=Xinfo(i, j);
+       cfg.xi[i].resize(cfg.numcut[i]);
+       for(size_t j=0;j<cfg.numcut[i];j++) cfg.xi[i][j]=Xinfo(i, j);
      }
-     bm.setxinfo(_xi);
    }
-#else
-
-#define TRDRAW(a, b) trdraw[a][b]
-#define TEDRAW(a, b) tedraw[a][b]
-
-void cgbart(
-   int type,            //1:wbart, 2:pbart, 3:lbart
-   size_t n,            //number of observations in training data
-   size_t p,		//dimension of x
-   size_t np,		//number of observations in test data
-   double* ix,		//x, train,  pxn (transposed so rows are contiguous in memory)
-   double* iy,		//y, train,  nx1
-   double* ixp,		//x, test, pxnp (transposed so rows are contiguous in memory)
-   size_t m,		//number of trees
-   int *numcut,		//number of cut points
-   size_t nd,		//number of kept draws (except for thinnning ..)
-   size_t burn,		//number of burn-in draws skipped
-   size_t thin,		//thinning
-   double mybeta,
-   double alpha,
-   double Offset,
-   double tau,
-   double nu,
-   double lambda,
-   double sigma,
-   double* iw,
-   bool dart,           //dart prior: true(1)=yes, false(0)=no   
-   double theta,
-   double omega, 
-   int* grp,
-   double a,		//param a for sparsity prior                                          
-   double b,		//param b for sparsity prior                                          
-//   double rho,		//param rho for sparsity prior (default to p)                         
-   bool aug,		//categorical strategy: true(1)=data augment false(0)=degenerate trees
-//   size_t nkeeptrain, //   size_t nkeeptest, //   size_t nkeeptreedraws,
-   size_t printevery,
-   unsigned int n1, // additional parameters needed to call from C++
-   unsigned int n2,
-   double* sdraw,
-   double* _trdraw,
-   double* _tedraw
-)
-{
-   //return data structures (using C++)
-   size_t nkeeptrain=nd/thin, nkeeptest=nd/thin, nkeeptreedraws=nd/thin;
-   std::vector<double*> trdraw(nkeeptrain);
-   std::vector<double*> tedraw(nkeeptest);
-
-   for(size_t i=0; i<nkeeptrain; ++i) trdraw[i]=&_trdraw[i*n];
-   for(size_t i=0; i<nkeeptest; ++i) tedraw[i]=&_tedraw[i*np];
-
-   //matrix to return dart posteriors (counts and probs)
-   std::vector< std::vector<size_t> > varcnt;
-   std::vector< std::vector<double> > varprb;
 
    //random number generation
-   arn gen(n1, n2);
-   heterbart bm(m);
-   int shards=1;
-#endif
-
-   /* multiple imputation hot deck implementation
-      this will cause trouble for multiple threads
-      so it must be done prior to calling C++ */
-/*
-   bool hotdeck=false;
-
-   std::vector<int> _missing(n*p);
-   std::vector<int*> missing(n);
-   std::vector<double*> x(n);
-   Rcpp::NumericMatrix X(n, p); 
-
-   for(size_t i=0; i<n; ++i) {
-     missing[i]=&_missing[i*p];
-     x[i]=&ix[i*p];
-     for(size_t j=0; j<p; ++j) 
-       if(x[i][j]!=x[i][j]) {
-	 hotdeck=true;
-	 missing[i][j]=1;
-       }
-       else missing[i][j]=0;
-   }     
-
-   if(hotdeck) {
-     for(size_t i=0; i<n; ++i) {
-       for(size_t j=0; j<p; ++j) { 
-	 if(missing[i][j]==1) {
-	   while(x[i][j]!=x[i][j]) {
-	     size_t k=n*gen.uniform();
-	     x[i][j]=x[k][j];
-	   }
-	 }
-	 X(i, j)=x[i][j]; 
-       }
-     }    
-   } 
-*/
-
-   std::stringstream treess;  //string stream to write trees to
-   treess.precision(10);
-   treess << nkeeptreedraws << " " << m << " " << p << endl;
-
-   printf("*****Calling gbart: type=%d\n", type);
-
-   size_t skiptr=thin, skipte=thin, skiptreedraws=thin;
-/*
-   size_t skiptr,skipte,skipteme,skiptreedraws;
-   if(nkeeptrain) {skiptr=nd/nkeeptrain;}
-   else skiptr = nd+1;
-   if(nkeeptest) {skipte=nd/nkeeptest;}
-   else skipte=nd+1;
-   if(nkeeptreedraws) {skiptreedraws = nd/nkeeptreedraws;}
-   else skiptreedraws=nd+1;
-*/
-
-   //--------------------------------------------------
-   //print args
-   printf("*****Data:\n");
-   printf("n,p,np: %zu, %zu, %zu\n",n,p,np);
-   printf("y1,yn: %lf, %lf\n",iy[0],iy[n-1]);
-   printf("x1,x[n*p]: %lf, %lf\n",ix[0],ix[n*p-1]);
-//   if(hotdeck) 
-//printf("warning: missing elements in x multiply imputed with hot decking\n");
-   if(np) printf("xp1,xp[np*p]: %lf, %lf\n",ixp[0],ixp[np*p-1]);
-   printf("*****Number of Trees: %zu\n",m);
-   printf("*****Number of Cut Points: %d ... %d\n", numcut[0], numcut[p-1]);
-   printf("*****burn,nd,thin: %zu,%zu,%zu\n",burn,nd,thin);
-   printf("*****Value of treeinit: %zu\n", treeinit);
-// printf("Prior:\nbeta,alpha,tau,nu,lambda,offset: %lf,%lf,%lf,%lf,%lf,%lf\n",
-//                    mybeta,alpha,tau,nu,lambda,Offset);
-   cout << "*****Prior:beta,alpha,tau,nu,lambda,offset,shards:\n" 
-	<< mybeta << ',' << alpha << ',' << tau << ',' 
-        << nu << ',' << lambda << ',' << Offset << ',' << shards << endl;
-if(type==1) {
-   printf("*****sigma: %lf\n",sigma);
-   printf("*****w (weights): %lf ... %lf\n",iw[0],iw[n-1]);
-}
-   if(K>0) {
-     cout << "*****Missing imputation row indices:\n index 0=" << impute_miss[0] << ','
-	  << "index n-1=" << impute_miss[n-1] << endl;
-     cout << "*****Missing imputation column indices:\n index 0=" << impute_mult[0] << ','
-	  << "index K-1=" << impute_mult[K-1] << endl;
-     // cout << "*****Missing imputation probability: prob[0]=" << impute_prior[0] << ','
-     // 	  << "prob[K-1]=" << impute_prior[K-1] << endl;
-   }
-   //printf("*****nkeeptrain,nkeeptest: %zu, %zu\n",nkeeptrain,nkeeptest);
-   //printf("*****printevery: %zu\n",printevery);
-   if(sparse==1) cout << "*****Variable Selection: traditional BART\ns[0], ..., s[p-1]:" << endl << varprob[0] << "..." << varprob[p-1] << endl;
-   else if(sparse==2) cout << "*****Variable Selection: Dirichlet prior\ntheta,a,b,rho" << theta << ',' << a << ',' << b << ',' << rho << endl;
-   else if(sparse==3&noan==0) cout << "*****Variable Selection: Logit-normal prior w/o Annotations\n beta prior variance, tau^2 scale parameter:" << endl << bprvar << ',' << tprprm << endl;
-   else if(sparse==3&noan!=0) cout << "*****Variable Selection: Logit-normal prior w/ Annotations\n beta prior variance, tau^2 scale parameter, number of annotations:" << endl << bprvar << ',' << tprprm << ',' << noan << endl;
-      else if(sparse==4&noan!=0) cout << "*****Variable Selection: Logit-normal prior w/ Annotations LASSO\n beta prior variance, tau^2 scale parameter, number of annotations:" << endl << bprvar << ',' << tprprm << ',' << noan << endl;
-   //--------------------------------------------------
-   //create temporaries
-   double df=n+nu;
-   double *z = new double[n]; 
-   double *svec = new double[n]; 
-   double *sign;
-   if(type!=1) sign = new double[n]; 
-   Rcpp::IntegerVector prevXV(p);
-
-   for(size_t i=0; i<n; i++) {
-     if(type==1) {
-       svec[i] = iw[i]*sigma; 
-       z[i] = iy[i];
-     }
-     else {
-       svec[i] = iw[i];
-       //svec[i] = 1.;
-       if(iy[i]==0) sign[i] = -1.;
-       else sign[i] = 1.;
-       z[i] = sign[i];
-       //z[i] = sign[i]*iw[i];
-     }
-     if(K>0) {
-       if(impute_miss[i]==1) {
-       //if(impute_miss[i]>0) {
-	 for(size_t j=0; j<K; j++) {
-	   XV(impute_mult[j], i)=0;
-	   prevXV[impute_mult[j]]=0;
-	 }
-	 size_t k;
-	 Rcpp::NumericVector impute_prob(impute_prior.row(i));
-	 k=gen.rcat(impute_prob); // use prior prob only
-	 XV(impute_mult[k], i)=1;
-	 prevXV[impute_mult[k]]=1;
-       }
-     }
-     else if(impute_miss[i]==2) 
-       for(size_t j=0; j<K; j++) 
-	 XV(impute_mult[j], i)=prevXV[impute_mult[j]];
-   }
-   //--------------------------------------------------
-   //set up BART model
-   bm.setprior(alpha,mybeta,tau);
-   bm.setdata(p,n,ix,z,numcut);
-   vs varsel(sparse,p);
-   if(sparse==1) {
-     bm.setpv(&varprob[0]);
-   }
-   else if(sparse==2) {
-     varsel.setvs_dart(a,b,false,rho,theta,0.);
-     bm.setpv(&varprob[0]);
-   }
-   else if(sparse==3) {
-     varsel.setvs_ln(bprvar,tprprm,an,noan,false,gen);
-     bm.setpv(&varprob[0]);
-   }
-   else {
-     varsel.setvs_ln(bprvar,tprprm,an,noan,true,gen);
-     bm.setpv(&varprob[0]);
-   }
-   if(treeinit==1) {
-     Rcpp::CharacterVector itrees(_itrees); 
-     std::string itv(itrees[0]);
-     bm.settree(itv);
-   }
-   //bm.setdart(a,b,rho,aug,dart);
-
-   // dart iterations
-   Rcpp::NumericVector ivarprb(p,0.);
-   std::vector<size_t> ivarcnt (p,0);
-   ivarprb=bm.getpv();
-
-   //--------------------------------------------------
-   //temporary storage
-   //out of sample fit
-   double* fhattest=0; 
-   if(np) { fhattest = new double[np]; }
-
-   //--------------------------------------------------
-   //mcmc
-   printf("\nMCMC\n");
-   //size_t index;
-   size_t trcnt=0; //count kept train draws
-   size_t tecnt=0; //count kept test draws
-   bool keeptest,/*keeptestme*/keeptreedraw,
-     type1sigest=(type==1 && lambda!=0.);
-
-   time_t tp;
-   int time1 = time(&tp), total=nd+burn;
-   xinfo& xi = bm.getxinfo();
-   
-   for(size_t i=0;i<total;i++) {
-      if(i%printevery==0) printf("done %zu (out of %lu)\n",i,nd+burn);
-      //if(i%printevery==0) printf("%22zu/%zu\r",i,total);
-      if(i==(burn/2)) varsel.turn_on();
-      //draw bart
-      bm.draw(svec,gen,shards);
-      //accept[i]=bm.getaccept();
-      std::vector<size_t> nv = bm.getnv();
-      std::vector<double> lpv (p,0.);
-      if(varsel.is_on()) {
-        size_t R=0;
-        for(size_t j=0;j<p;j++) R+=nv[j];
-        varsel.set_R(R);
-        if(varsel.get_sparse()==2){
-          //          if(varsel.has_grp()) varsel.draw_s_grp_dart(nv,lpv,gen);
-          varsel.draw_s_dart(lpv,nv,gen);
-          varsel.draw_theta0_dart(lpv,gen);
-        }
-        else if(varsel.get_sparse()==3){
-          varsel.draw_s_ln(nv,lpv,gen);
-          varsel.draw_tau2_ln(gen);
-        }
-        else if(varsel.get_sparse()==4){
-          varsel.draw_s_ln(nv,lpv,gen);
-          varsel.draw_tau2_ln(gen);
-          varsel.draw_lambda_lnLASSO(gen);
-        }
-        if(varsel.get_sparse()!=1) for(size_t j=0;j<p;j++) ivarprb[j]=::exp(lpv[j]);
-        bm.setpv(&ivarprb[0]);
-      }
-      
-      if(type1sigest) {
-      //draw sigma
-	double rss=0.;
-	for(size_t k=0;k<n;k++) rss += pow((iy[k]-bm.f(k))/(iw[k]), 2.); 
-	sigma = sqrt((nu*lambda + rss)/gen.chi_square(df));
-	sdraw[i]=sigma;
-      }
-
-      for(size_t k=0; k<n; k++) {
-	if(type==1) svec[k]=iw[k]*sigma;
-	else {
-	  z[k]=sign[k]*rtnorm(sign[k]*bm.f(k), -sign[k]*Offset, svec[k], gen);
-	  if(type==3) 
-	    svec[k]=sqrt(draw_lambda_i(pow(svec[k], 2.), sign[k]*bm.f(k), 
-				       1000, 1, gen));
-	  }
-      }
-
-      if(K>0) {
-	for(size_t k=0; k<n; ++k) {
-	  if(impute_miss[k]==1) {
-	  //if(impute_miss[k]>0) {
-	    impute_Xrow_ptr=&XV(0, k);
-	    impute_post=impute_prior.row(k);
-	    for(size_t j=0; j<K; ++j) {
-	      for(size_t h=0; h<K; ++h) XV(impute_mult[h], k)=0;
-	      XV(impute_mult[j], k)=1;
-	      bm.predict(p, 1, impute_Xrow_ptr, &impute_fhat_ptr[j]);
-	      impute_post[j] *= R::dnorm(z[k], impute_fhat_ptr[j], svec[k], 0); 
-	    }
-	    for(size_t j=0; j<K; j++) { 
-	      XV(impute_mult[j], k)=0;
-	      prevXV[impute_mult[j]]=0;
-	    }
-	    size_t h;
-	    h=gen.rcat(impute_post); 
-	    XV(impute_mult[h], k)=1;
-	    prevXV[impute_mult[h]]=1;
-	  }
-	  else if(impute_miss[k]==2) 
-	    for(size_t j=0; j<K; j++) 
-	      XV(impute_mult[j], k)=prevXV[impute_mult[j]];
-	}
-      }
-
-/*
-      if(hotdeck) {
-	//draw x
-	for(size_t h=0; h<n; ++h) {
-	  for(size_t j=0; j<p; ++j) {
-	    if(missing[h][j]==1) {
-	      size_t k=n*gen.uniform();
-	      x[h][j]=x[k][j];
-	    }
-	  }
-	}    
-      } 
-*/
-
-      if(i>=burn) {
-	//size_t idcnt=0;
-         if(nkeeptrain && (((i-burn+1) % skiptr) ==0)) {
-            for(size_t k=0;k<n;k++) {
-	      TRDRAW(trcnt,k)=Offset+bm.f(k);
-	      if(K>0) {
-		if(impute_miss[k]==1) {
-		  IMPUTE_DRAW1(trcnt,k)=XV(impute_mult[0], k);
-		  IMPUTE_DRAW2(trcnt,k)=XV(impute_mult[1], k);
-		} else {
-		  IMPUTE_DRAW1(trcnt,k)=2;
-		  IMPUTE_DRAW2(trcnt,k)=2;
-		}
-	      }
-/*
-	      for(size_t j=0; j<K; ++j) {
-		impute_draw[idcnt]=XV(impute_mult[j], k);
-		idcnt+=1;
-		//impute_draw(trcnt, k, j)=XV(impute_mult[j], k);
-	      }
-*/
-	    }
-	    trcnt+=1;
-         }
-         keeptest = nkeeptest && (((i-burn+1) % skipte) ==0) && np;
-         if(keeptest) {
-	   bm.predict(p,np,ixp,fhattest);
-            for(size_t k=0;k<np;k++) TEDRAW(tecnt,k)=Offset+fhattest[k];
-            tecnt+=1;
-         }
-         keeptreedraw = nkeeptreedraws && (((i-burn+1) % skiptreedraws) ==0);
-         if(keeptreedraw) {
-	    size_t k=(i-burn)/skiptreedraws;
-            for(size_t j=0;j<m;j++) {
-	      treess << bm.gettree(j);
-
-	      #ifndef NoRcpp
-	    ivarcnt=bm.getnv();
-//	    size_t k=(i-burn)/skiptreedraws;
-	    for(size_t h=0;h<p;h++){
-	      varcnt(k,h)=ivarcnt[h];
-	      varprb(k,h)=ivarprb[h];
-	    }
-/* dangerous re-use of j
-	    for(size_t j=0;j<p;j++){
-	      varcnt(k,j)=ivarcnt[j];
-	      varprb(k,j)=ivarprb[j];
-	    }
-*/
-            #else
-	    varcnt.push_back(bm.getnv());
-	    varprb.push_back(bm.getpv());
-	    #endif
-	    }
-         }
-      }
-   }
-   int time2 = time(&tp);
-   printf("time: %ds\n",time2-time1);
-   printf("trcnt,tecnt: %zu,%zu\n",trcnt,tecnt);
+   arn gen;
 
-   if(fhattest) delete[] fhattest;
-   delete[] z;
-   delete[] svec;
-   if(type!=1) delete[] sign;
+   Rgbartsink out;
+   if(!gbart(cfg, ix, iy, ixp, iw, &varprob[0], gen, out))
+     Rcpp::stop("can't resume from the checkpoint "+cfg.resume);
 
-#ifndef NoRcpp
    //return list
    Rcpp::List ret;
-//   ret["X"]=X; 
-   if(type1sigest) ret["sigma"]=sdraw;
-   ret["yhat.train"]=trdraw;
-   ret["yhat.test"]=tedraw;
-   ret["varcount"]=varcnt;
-   ret["varprob"]=varprb;
-   //ret["accept"]=accept;
-
-   Rcpp::List xiret(xi.size());
-   for(size_t i=0;i<xi.size();i++) {
-      Rcpp::NumericVector vtemp(xi[i].size());
-      std::copy(xi[i].begin(),xi[i].end(),vtemp.begin());
-      xiret[i] = Rcpp::NumericVector(vtemp);
+   if(cfg.resume.size()>0) ret["start"]=out.start;
+   if(cfg.type==1 && cfg.lambda!=0.) ret["sigma"]=out.sdraw;
+   ret["yhat.train"]=out.trdraw;
+   ret["yhat.test"]=out.tedraw;
+   ret["varcount"]=out.varcnt;
+   ret["varprob"]=out.varprb;
+   if(cfg.ndiag()) {
+     ret["diagnostics"]=out.diagnostics;
+     ret["treeshape"]=Rcpp::List::create(Rcpp::Named("depth")=out.shdepth,
+					 Rcpp::Named("leaves")=out.shleaves);
    }
 
    Rcpp::List treesL;
-   treesL["cutpoints"] = xiret;
-   treesL["trees"]=Rcpp::CharacterVector(treess.str());
+   treesL["cutpoints"] = out.xiret;
+   treesL["trees"]=Rcpp::CharacterVector(out.treess.str());
+   if(cfg.treeshape) {
+     treesL["depth"]=out.trdepth;
+     treesL["leaves"]=out.trleaves;
+   }
+   if(cfg.treecover) treesL["cover"]=Rcpp::CharacterVector(out.coverss.str());
    ret["treedraws"] = treesL;
 
    if(K>0) {
-     ret["impute.draw1"]=impute_draw1;
-     ret["impute.draw2"]=impute_draw2;
+     ret["impute.draw1"]=out.impute_draw1;
+     ret["impute.draw2"]=out.impute_draw2;
    }
-   //if(K>0) ret["impute.mult"]=impute_draw;
    cout << "Hi\n";
    return ret;
-#else
-
-#endif
-
+   END_RCPP
 }
@@ -19,134 +19,72 @@
  *  https://www.R-project.org/Licenses/GPL-3
  */
 
+//hot-deck prediction: for sample k and setting i of xtest, the columns
+//not in mask are those of a donor row of xtrain drawn uniformly from the
+//rows without missing values there; the donors are drawn from counter-
+//based streams keyed by (k, i) under a seed from R's generator, so the
+//draws are the same for any thread count, and the setting is copied to
+//a row of the thread rather than xtest rewritten for each sample
 RcppExport SEXP chotdeck(
-			 SEXP _itrain,
-			 SEXP _itest,
-			 SEXP _imask,
-			 SEXP _itrees
-			 //SEXP _multimpute
-			 //treedraws list from fbart
-			 //   SEXP _itc		//thread count
+			 SEXP _itrain,	//x.train, p x n
+			 SEXP _itest,	//x.test, p x np
+			 SEXP _imask,	//1 condition, 0 hot deck
+			 SEXP _itrees,	//treedraws list from gbart, or a bart_forest
+			 SEXP _itc	//thread count
 			 )
 {
-  //Rprintf("*****In main of C++ for bart prediction\n");
-  //random number generation
+  BEGIN_RCPP
+  int tc = Rcpp::as<int>(_itc);
   arn gen;
-  //--------------------------------------------------
-  //OpenMP will not work here since we cannot 
-  //estimate 1, ..., nd predictions simultaneously
-  //for each sample, we need to hotdeck the values
-  //however, we can parallel-ize predictions 1, ..., np
-  //but we are not using OpenMP: just multiple threads
-  //each given a block of xtest which is even easier
-  //int tc = Rcpp::as<int>(_itc);
-  //cout << "tc (threadcount): " << tc << endl;
+  uint64_t seed = (uint64_t)(gen.uniform()*4294967296.);
+  seed = (seed<<32) | (uint64_t)(gen.uniform()*4294967296.);
   //--------------------------------------------------
   //process trees
-  Rcpp::List trees(_itrees);
-  Rcpp::CharacterVector itrees(Rcpp::wrap(trees["trees"])); 
-  std::string itv(itrees[0]);
-  std::stringstream ttss(itv);
-
-  size_t nd, m, p;
-  ttss >> nd >> m >> p;
-  /*
-    cout << "number of bart draws: " << nd << endl;
-    cout << "number of trees in bart sum: " << m << endl;
-    cout << "number of x columns: " << p << endl;
-  */
-  //--------------------------------------------------
-  //process cutpoints (from trees)
-  Rcpp::List  ixi(Rcpp::wrap(trees["cutpoints"]));
-  size_t pp = ixi.size();
-  if(p!=pp) cout << "WARNING: p from trees and p from x don't agree\n";
-//  int multimpute=Rcpp::as<int>(_multimpute);
-  xinfo xi;
-  xi.resize(p);
-  for(size_t i=0;i<p;i++) {
-    Rcpp::NumericVector cutv(ixi[i]);
-    xi[i].resize(cutv.size());
-    std::copy(cutv.begin(),cutv.end(),xi[i].begin());
-  }
+  forest g;
+  const forest& f = getforest(_itrees,g);
+  size_t nd = f.getnd(), p = f.getp();
   //--------------------------------------------------
   //process x
   Rcpp::IntegerVector mask(_imask);
-  Rcpp::NumericMatrix xtrain(_itrain);
-  Rcpp::NumericMatrix xtest=Rcpp::clone(_itest);
-  size_t n = xtrain.ncol();
-  size_t np = xtest.ncol();
-  //cout << "from x,np,p: " << xtest.nrow() << ", " << xtest.ncol() << endl;
-  //--------------------------------------------------
-  //read in trees
-  std::vector<vtree> tmat(nd);
-  //  for(size_t i=0;i<nd;i++) tmat[i].resize(m);
-  for(size_t i=0;i<nd;i++) {
-    tmat[i].resize(m);
-    for(size_t j=0;j<m;j++) ttss >> tmat[i][j];
+  Rcpp::NumericMatrix xtrain(_itrain), xtest(_itest);
+  if((size_t)xtrain.nrow()!=p || (size_t)xtest.nrow()!=p || (size_t)mask.size()!=p)
+    Rcpp::stop("x.train, x.test and S must have the columns of the trees");
+  size_t n = xtrain.ncol(), np = xtest.ncol();
+  std::vector<size_t> hot, donor; //hot-decked columns, valid donor rows
+  for(size_t j=0; j<p; ++j) if(mask[j]==0) hot.push_back(j);
+  donor.reserve(n);
+  for(size_t h=0; h<n; ++h) {
+    size_t j=0;
+    for(; j<hot.size() && xtrain(hot[j], h)==xtrain(hot[j], h); ++j);
+    if(j==hot.size()) donor.push_back(h);
   }
+  if(donor.size()==0 && np>0 && nd>0)
+    Rcpp::stop("no row of x.train is complete in the hot-decked columns");
   //--------------------------------------------------
   //get predictions
-
   Rcpp::NumericMatrix yhat(nd,np);
-  std::fill(yhat.begin(), yhat.end(), 0.0);
-  double *px = &xtest(0,0);
-
-  /*
-  if(multimpute>1) {
-    for(size_t k=0; k<nd; ++k) {   // samples
-      Rcpp::NumericVector y(np);
-      for(size_t l=0; l<multimpute; ++l) {
-	for(size_t i=0; i<np; ++i) { // settings
-	  size_t h;
-	  h=n*gen.uniform();
-	  for(size_t j=0; j<p; ++j) { // variables: rows of xpred
-	    // check for missing values
-	    while(xtrain(j, h)!=xtrain(j, h)) h=n*gen.uniform();
-	    if(mask[j]==0) xtest(j, i)=xtrain(j, h);
-	  }
-	}
-	getpred(k, k, p, m, np, xi, tmat, px, yhat);
-	y += yhat.row(k);
-      }
-      yhat.row(k)=y/multimpute; 
-    }    
-  } else {
-*/
-    for(size_t k=0; k<nd; ++k) {   // samples
-      for(size_t i=0; i<np; ++i) { // settings
-	size_t h;
-	h=n*gen.uniform();
-	for(size_t j=0; j<p; ++j) {  // variables: rows of xpred
-	  // check for missing values
-	  while(xtrain(j, h)!=xtrain(j, h)) h=n*gen.uniform();
-	  if(mask[j]==0) xtest(j, i)=xtrain(j, h);
-	}
-      }
-      getpred(k, k, p, m, np, xi, tmat, px, yhat);
-    }
-//  }
-  
-  /*
-    double y;
-    for(size_t k=0; k<nd; ++k) {   // samples
-    for(size_t i=0; i<np; ++i) { // settings
-    size_t h;
-    h=n*gen.uniform();
-    for(size_t j=0; j<p; ++j)  // variables: rows of xpred
-    if(mask[j]==0) xtest(j, i)=xtrain(j, h);
-    // mimicking Friedman's partial dependence function
-    y=0.;
-    for(size_t l=0; l<n; ++l) {
-    getpred(k, k, p, m, np, xi, tmat, px, yhat);
-    y += yhat(k, i);
-    }
-    yhat(k, i)=y/n;
+  double *px = &xtest(0,0), *pt = &xtrain(0,0), *py = &yhat(0,0);
+  size_t N = nd*np, nh = hot.size(), nn = donor.size();
+#ifdef _OPENMP
+#pragma omp parallel num_threads(tc)
+#endif
+  {
+    std::vector<double> x(p);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for(size_t ki=0; ki<N; ++ki) { //sample k, setting i
+      size_t k=ki%nd, i=ki/nd;
+      ctrrn u(seed, k, i);
+      double *xi=px+i*p, *xh=pt+donor[(size_t)(u.uniform()*nn)]*p;
+      std::copy(xi, xi+p, x.begin());
+      for(size_t j=0; j<nh; ++j) x[hot[j]]=xh[hot[j]];
+      py[ki]=f.predict(k, &x[0]);
     }
-    }
-  */
-   
+  }
   //--------------------------------------------------
   Rcpp::List ret;
   ret["yhat.test"] = yhat;
   return ret;
+  END_RCPP
 }
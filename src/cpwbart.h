@@ -19,21 +19,15 @@
  *  https://www.R-project.org/Licenses/GPL-3
  */
 
-typedef std::vector<tree> vtree;
-
-#ifdef _OPENMP
-void local_getpred(size_t nd, size_t p, size_t m, size_t np, xinfo& xi, 
-std::vector<vtree>& tmat, double *px, Rcpp::NumericMatrix& yhat);
-#endif
-
-void getpred(int beg, int end, size_t p, size_t m, size_t np, xinfo& xi, std::vector<vtree>& tmat, double *px, Rcpp::NumericMatrix& yhat);
-
+//the trees are read from treedraws, or taken from a bart_forest, into a
+//forest (forest.h) once and each draw predicts every column of x
 RcppExport SEXP cpwbart(
-   SEXP _itrees,		//treedraws list from fbart
+   SEXP _itrees,		//treedraws list from fbart, or a bart_forest
    SEXP _ix,			//x matrix to predict at
    SEXP _itc			//thread count
 )
 {
+   BEGIN_RCPP
    Rprintf("*****In main of C++ for bart prediction\n");
    //--------------------------------------------------
    //get threadcount
@@ -41,88 +35,38 @@ RcppExport SEXP cpwbart(
    cout << "tc (threadcount): " << tc << endl;
    //--------------------------------------------------
    //process trees
-   Rcpp::List trees(_itrees);
-   Rcpp::CharacterVector itrees(Rcpp::wrap(trees["trees"])); 
-   std::string itv(itrees[0]);
-   std::stringstream ttss(itv);
-
-   size_t nd,m,p;
-   ttss >> nd >> m >> p;
+   forest g;
+   const forest& f = getforest(_itrees,g);
+   size_t nd = f.getnd(), m = f.getm(), p = f.getp();
    cout << "number of bart draws: " << nd << endl;
    cout << "number of trees in bart sum: " << m << endl;
    cout << "number of x columns: " << p << endl;
    //--------------------------------------------------
-   //process cutpoints (from trees)
-   Rcpp::List  ixi(Rcpp::wrap(trees["cutpoints"]));
-   size_t pp = ixi.size();
-   if(p!=pp) cout << "WARNING: p from trees and p from x don't agree\n";
-   xinfo xi;
-   xi.resize(p);
-   for(size_t i=0;i<p;i++) {
-      Rcpp::NumericVector cutv(ixi[i]);
-      xi[i].resize(cutv.size());
-      std::copy(cutv.begin(),cutv.end(),xi[i].begin());
-   }
-   //--------------------------------------------------
    //process x
    Rcpp::NumericMatrix xpred(_ix);
    size_t np = xpred.ncol();
    cout << "from x,np,p: " << xpred.nrow() << ", " << xpred.ncol() << endl;
+   if((size_t)xpred.nrow()!=p)
+      Rcpp::stop("x.test must have the columns of the trees");
    //--------------------------------------------------
-   //read in trees
-   std::vector<vtree> tmat(nd);
-   for(size_t i=0;i<nd;i++) tmat[i].resize(m);
-   for(size_t i=0;i<nd;i++) {
-      for(size_t j=0;j<m;j++) ttss >> tmat[i][j];
-   }
-   //--------------------------------------------------
-   //get predictions
-
+   //get predictions: the threads share the forest and each predicts a
+   //block of the rows of x (columns of xpred) for every draw straight
+   //into yhat
    Rcpp::NumericMatrix yhat(nd,np);
-   std::fill(yhat.begin(), yhat.end(), 0.0);
-   double *px = &xpred(0,0);
+   double *px = &xpred(0,0), *py = &yhat(0,0);
 
-   #ifndef _OPENMP
+#ifdef _OPENMP
+   if(tc>1) cout << "***using parallel code\n";
+   else cout << "***using serial code\n";
+#pragma omp parallel for num_threads(tc) schedule(static)
+#else
    cout << "***using serial code\n";
-   getpred(0, nd-1, p, m, np,  xi,  tmat, px,  yhat);
-   #else
-   if(tc==1) {
-     cout << "***using serial code\n"; 
-     getpred(0, nd-1, p, m, np,  xi,  tmat, px,  yhat);
-   }
-   else {
-      cout << "***using parallel code\n";
-#pragma omp parallel num_threads(tc)
-      local_getpred(nd,p,m,np,xi,tmat,px,yhat);
-   }
-   #endif
+#endif
+   for(size_t k=0;k<np;k++)
+      for(size_t i=0;i<nd;i++) py[i+k*nd] = f.predict(i,px+k*p);
 
    Rcpp::List ret;
    ret["yhat.test"] = yhat;
    return ret;
+   END_RCPP
 }
-
-void getpred(int beg, int end, size_t p, size_t m, size_t np, xinfo& xi, std::vector<vtree>& tmat, double *px, Rcpp::NumericMatrix& yhat)
-{
-   double *fptemp = new double[np];
-
-   for(int i=beg;i<=end;i++) {
-      for(size_t j=0;j<m;j++) {
-         fit(tmat[i][j],xi,p,np,px,fptemp);
-         for(size_t k=0;k<np;k++) yhat(i,k) += fptemp[k];
-      }
-   }
-
-   delete [] fptemp;
-}
-#ifdef _OPENMP
-void local_getpred(size_t nd, size_t p, size_t m, size_t np, xinfo& xi, 
-std::vector<vtree>& tmat, double *px, Rcpp::NumericMatrix& yhat)
-{
-   int my_rank = omp_get_thread_num();
-   int thread_count = omp_get_num_threads();
-   int h = nd/thread_count; int beg = my_rank*h; int end = beg+h-1;
-   
-   getpred(beg,end,p,m,np,xi,tmat,px,yhat);
-}
-#endif
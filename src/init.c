@@ -7,13 +7,18 @@
 /* extern SEXP cmbart(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP); */
 extern SEXP cpwbart(SEXP, SEXP, SEXP);
 extern SEXP chotdeck(SEXP, SEXP, SEXP, SEXP, SEXP);
-extern SEXP cgbart(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP cgbart(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 /*extern SEXP cspbart(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);*/
 extern SEXP mc_cores_openmp();
 extern SEXP crtnorm(SEXP, SEXP, SEXP, SEXP);
 extern SEXP crtgamma(SEXP, SEXP, SEXP, SEXP);
 extern SEXP cdraw_lambda_i(SEXP, SEXP, SEXP, SEXP);
-extern SEXP cEXPVALUE(SEXP, SEXP, SEXP);
+extern SEXP cdraw_lambda(SEXP, SEXP, SEXP, SEXP);
+extern SEXP cEXPVALUE(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP cTREESHAP(SEXP, SEXP, SEXP, SEXP);
+extern SEXP cREADTREES(SEXP, SEXP, SEXP);
+extern SEXP cFOREST(SEXP);
+extern SEXP cMAKECUTS(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 /*extern SEXP cdpmbart(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP cdpmwbart(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP cdpgbart(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);*/
@@ -22,14 +27,19 @@ static const R_CallMethodDef CallEntries[] = {
 /*  {"cmbart",  (DL_FUNC) &cmbart,  29},*/
     {"cpwbart", (DL_FUNC) &cpwbart,  3},
     {"chotdeck",(DL_FUNC) &chotdeck, 5},
-    {"cgbart",  (DL_FUNC) &cgbart,  42},
+    {"cgbart",  (DL_FUNC) &cgbart,  50},
 //  {"cgbmm",   (DL_FUNC) &cgbmm,   34}, 
 /*  {"cspbart",  (DL_FUNC) &cspbart,  30}, */
     {"mc_cores_openmp",(DL_FUNC) &mc_cores_openmp,0},
     {"crtnorm", (DL_FUNC) &crtnorm,  4},
     {"crtgamma",(DL_FUNC) &crtgamma, 4},
     {"cdraw_lambda_i", (DL_FUNC) &cdraw_lambda_i, 4},
-    {"cEXPVALUE", (DL_FUNC) &cEXPVALUE, 3},
+    {"cdraw_lambda", (DL_FUNC) &cdraw_lambda, 4},
+    {"cEXPVALUE", (DL_FUNC) &cEXPVALUE, 5},
+    {"cTREESHAP", (DL_FUNC) &cTREESHAP, 4},
+    {"cREADTREES", (DL_FUNC) &cREADTREES, 3},
+    {"cFOREST", (DL_FUNC) &cFOREST, 1},
+    {"cMAKECUTS", (DL_FUNC) &cMAKECUTS, 6},
 /*  {"cdpgbart",(DL_FUNC) &cdpgbart,35},
     {"cdpmbart",(DL_FUNC) &cdpmbart,25},
     {"cdpmwbart",(DL_FUNC) &cdpmwbart,27}, */